@@ -0,0 +1,230 @@
+// Microbenchmark harness for the libisofuzz hot paths.
+//
+// Drives the public API from N synthetic worker threads and reports
+// events/sec plus p50/p99/max per-op latency, so scheduler and logger
+// regressions are catchable in seconds instead of full-DBMS sysbench runs.
+// Build with -DISOFUZZ_BUILD_BENCH=ON; the scheduler/logger are configured
+// through the usual environment variables (ISOFUZZ_EPOCH_MS, OUT_FILE,
+// ISOFUZZ_ASYNC_LOG, ...).
+//
+// Usage:
+//   isofuzz_bench [--mode log|sched|txn|mixed] [--threads N]
+//                 [--seconds S] [--pace-us U]
+//
+//   log    isofuzz_log_op only (logger hot path)
+//   sched  isofuzz_schedule_data_op only (scheduler round trip)
+//   txn    isofuzz_trx_begin/isofuzz_trx_end churn
+//   mixed  begin, schedule+log a few row ops, commit, end
+//
+// --pace-us inserts a fixed sleep between operations to benchmark at a
+// target op rate instead of at saturation.
+
+#include "isofuzz.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+struct BenchConfig
+{
+  std::string mode = "mixed";
+  int threads = 8;
+  int seconds = 5;
+  long pace_us = 0;
+};
+
+struct WorkerResult
+{
+  std::vector<uint64_t> latencies_ns; // One sample per operation.
+};
+
+using Clock = std::chrono::steady_clock;
+
+std::atomic<bool> g_stop(false);
+
+// Measures one call and appends its latency.
+template <typename Fn>
+inline void timed_op(WorkerResult& result, Fn&& fn)
+{
+  auto start = Clock::now();
+  fn();
+  auto end = Clock::now();
+  result.latencies_ns.push_back(
+    static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+}
+
+void pace(const BenchConfig& cfg)
+{
+  if (cfg.pace_us > 0)
+  {
+    std::this_thread::sleep_for(std::chrono::microseconds(cfg.pace_us));
+  }
+}
+
+void worker_run(const BenchConfig& cfg, int worker_id, WorkerResult& result)
+{
+  result.latencies_ns.reserve(1u << 20);
+  uint64_t row = static_cast<uint64_t>(worker_id) << 32;
+
+  if (cfg.mode == "txn")
+  {
+    while (!g_stop.load(std::memory_order_relaxed))
+    {
+      timed_op(result, [] {
+        isofuzz_trx_t trx = isofuzz_trx_begin();
+        isofuzz_trx_end(trx);
+      });
+      pace(cfg);
+    }
+    return;
+  }
+
+  // The remaining modes operate inside a long-lived or per-iteration
+  // transaction.
+  if (cfg.mode == "log" || cfg.mode == "sched")
+  {
+    isofuzz_trx_t trx = isofuzz_trx_begin();
+    while (!g_stop.load(std::memory_order_relaxed))
+    {
+      IsoFuzzObject obj{"bench_table", "c", ++row};
+      if (cfg.mode == "log")
+      {
+        timed_op(result, [&] {
+          isofuzz_log_op(trx, IsoFuzzOpType::WRITE_UPDATE, obj, 0);
+        });
+      }
+      else
+      {
+        timed_op(result, [&] {
+          isofuzz_schedule_data_op(trx, IsoFuzzSchedulerIntent::OP_WRITE, obj);
+        });
+      }
+      pace(cfg);
+    }
+    isofuzz_trx_end(trx);
+    return;
+  }
+
+  // mixed: a short transaction of scheduled+logged row operations, the
+  // closest shape to real adapter traffic.
+  while (!g_stop.load(std::memory_order_relaxed))
+  {
+    timed_op(result, [&] {
+      isofuzz_trx_t trx = isofuzz_trx_begin();
+      for (int i = 0; i < 4; ++i)
+      {
+        IsoFuzzObject obj{"bench_table", "c", ++row};
+        isofuzz_schedule_data_op(trx, IsoFuzzSchedulerIntent::OP_WRITE, obj);
+        isofuzz_log_op(trx, IsoFuzzOpType::WRITE_UPDATE, obj, 0);
+      }
+      isofuzz_trx_commit(trx);
+      isofuzz_trx_end(trx);
+    });
+    pace(cfg);
+  }
+}
+
+uint64_t percentile(std::vector<uint64_t>& sorted, double p)
+{
+  if (sorted.empty()) return 0;
+  size_t idx = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1));
+  return sorted[idx];
+}
+
+bool parse_args(int argc, char** argv, BenchConfig& cfg)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    auto next_value = [&](long& out) {
+      if (i + 1 >= argc) return false;
+      out = std::stol(argv[++i]);
+      return true;
+    };
+    long value = 0;
+    if (std::strcmp(argv[i], "--mode") == 0 && i + 1 < argc)
+    {
+      cfg.mode = argv[++i];
+    }
+    else if (std::strcmp(argv[i], "--threads") == 0 && next_value(value))
+    {
+      cfg.threads = static_cast<int>(value);
+    }
+    else if (std::strcmp(argv[i], "--seconds") == 0 && next_value(value))
+    {
+      cfg.seconds = static_cast<int>(value);
+    }
+    else if (std::strcmp(argv[i], "--pace-us") == 0 && next_value(value))
+    {
+      cfg.pace_us = value;
+    }
+    else
+    {
+      std::fprintf(stderr, "Unknown or incomplete argument: %s\n", argv[i]);
+      return false;
+    }
+  }
+  if (cfg.mode != "log" && cfg.mode != "sched" && cfg.mode != "txn" && cfg.mode != "mixed")
+  {
+    std::fprintf(stderr, "Unknown mode '%s' (expected log|sched|txn|mixed)\n", cfg.mode.c_str());
+    return false;
+  }
+  return cfg.threads > 0 && cfg.seconds > 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  BenchConfig cfg;
+  if (!parse_args(argc, argv, cfg))
+  {
+    return 1;
+  }
+
+  isofuzz_init();
+
+  std::vector<WorkerResult> results(static_cast<size_t>(cfg.threads));
+  std::vector<std::thread> workers;
+  workers.reserve(static_cast<size_t>(cfg.threads));
+
+  auto bench_start = Clock::now();
+  for (int i = 0; i < cfg.threads; ++i)
+  {
+    workers.emplace_back(worker_run, std::cref(cfg), i, std::ref(results[static_cast<size_t>(i)]));
+  }
+
+  std::this_thread::sleep_for(std::chrono::seconds(cfg.seconds));
+  g_stop.store(true, std::memory_order_relaxed);
+  for (auto& w : workers)
+  {
+    w.join();
+  }
+  auto elapsed_s = std::chrono::duration<double>(Clock::now() - bench_start).count();
+
+  isofuzz_shutdown();
+
+  std::vector<uint64_t> all;
+  for (const auto& r : results)
+  {
+    all.insert(all.end(), r.latencies_ns.begin(), r.latencies_ns.end());
+  }
+  std::sort(all.begin(), all.end());
+
+  std::printf("mode=%s threads=%d seconds=%d pace_us=%ld\n",
+              cfg.mode.c_str(), cfg.threads, cfg.seconds, cfg.pace_us);
+  std::printf("ops           %zu\n", all.size());
+  std::printf("ops/sec       %.0f\n", static_cast<double>(all.size()) / elapsed_s);
+  std::printf("p50 latency   %lu ns\n", static_cast<unsigned long>(percentile(all, 0.50)));
+  std::printf("p99 latency   %lu ns\n", static_cast<unsigned long>(percentile(all, 0.99)));
+  std::printf("max latency   %lu ns\n", all.empty() ? 0ul : static_cast<unsigned long>(all.back()));
+  return 0;
+}
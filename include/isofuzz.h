@@ -19,6 +19,16 @@ enum class IsoFuzzSchedulerIntent
   OP_WRITE // A generic write, covers INSERT, UPDATE, DELETE
 };
 
+// Per-thread scheduling mode. SCHEDULED threads block in the scheduler at
+// every schedule call; PASSTHROUGH threads skip scheduling entirely while
+// still logging, for background work (purge, checkpoint, replication
+// apply) that must appear in the trace but should never be interleaved.
+enum class IsoFuzzThreadMode
+{
+  SCHEDULED,
+  PASSTHROUGH
+};
+
 // The specific type of data operation, used for precise logging.
 enum class IsoFuzzOpType
 {
@@ -41,6 +51,17 @@ struct IsoFuzzObject
   uint64_t row_identifier;
 };
 
+// Like IsoFuzzObject, but with table and column pre-interned to integer
+// IDs (see isofuzz_intern_name). Adapters that log the same few dozen
+// names millions of times should intern once at startup and use this form
+// on the hot path, which removes all string handling from per-op logging.
+struct IsoFuzzObjectId
+{
+  uint32_t table_id;
+  uint32_t column_id; // Optional, 0 = no column
+  uint64_t row_identifier;
+};
+
 /*
  * ========================================================================
  * Library Lifecycle
@@ -62,6 +83,52 @@ void isofuzz_init();
  */
 void isofuzz_shutdown();
 
+/**
+ * @brief Forces all buffered log entries to be written and flushed.
+ * Only needed when asynchronous logging is enabled (ISOFUZZ_ASYNC_LOG=1),
+ * where trace output is otherwise written lazily by a background thread.
+ */
+void isofuzz_flush();
+
+// A snapshot of the library's hot-path counters. All values are cumulative
+// since isofuzz_init(). Averages derive trivially (e.g., mean batch size =
+// total_batch / epochs).
+struct IsoFuzzStats
+{
+  uint64_t requests;         // Scheduling requests submitted.
+  uint64_t releases;         // Waiters released by the scheduler.
+  uint64_t batched_releases; // Releases that shared a round with others.
+  uint64_t spin_wakeups;     // Waits satisfied while still spinning.
+  uint64_t parked_wakeups;   // Waits that fell back to the condition variable.
+  uint64_t epochs;           // Completed collect->drain cycles.
+  uint64_t total_batch;      // Sum of epoch batch sizes.
+  uint64_t max_batch;        // Largest single epoch batch.
+  uint64_t collecting_ns;    // Scheduler time spent in COLLECTING.
+  uint64_t draining_ns;      // Scheduler time spent in DRAINING.
+  uint64_t events_logged;    // Trace events produced.
+  uint64_t cancellations;    // Pending requests cancelled by abort paths.
+  uint64_t timeout_releases; // Entries force-released by the liveness watchdog.
+};
+
+/**
+ * @brief Fills *stats with a snapshot of the library's internal counters.
+ * Counters are relaxed atomics updated without locks, so the snapshot is
+ * not a consistent cut across fields, but each field is exact. Safe to
+ * call at any time from any thread; set ISOFUZZ_STATS_PERIOD_EPOCHS to
+ * also have the scheduler print a summary to stderr every N epochs.
+ */
+void isofuzz_get_stats(IsoFuzzStats* stats);
+
+/**
+ * @brief Dumps the in-memory trace to OUT_FILE.
+ * Only meaningful in ring-buffer trace mode (ISOFUZZ_TRACE_MODE=ring),
+ * where events are kept in preallocated per-thread circular buffers and
+ * written out only on demand: at shutdown, from the fatal-signal handler,
+ * or via this call (e.g., when an external oracle flags an anomaly). In
+ * stream modes this behaves like isofuzz_flush().
+ */
+void isofuzz_dump_trace();
+
 
 /*
  * ========================================================================
@@ -97,6 +164,19 @@ void isofuzz_trx_commit(isofuzz_trx_t trx_handle);
  */
 void isofuzz_trx_promote(isofuzz_trx_t trx_handle, uint64_t new_dbms_id);
 
+/**
+ * @brief Cancels a transaction's pending scheduling request, if one exists.
+ * Call from abort paths: a thread blocked in a schedule call for this
+ * transaction is released immediately, and the scheduler reclaims the
+ * entry instead of stalling a release round on a transaction that will
+ * never run. Best-effort and safe to call from any thread at any time —
+ * if no request is pending this is a no-op. See also
+ * ISOFUZZ_RELEASE_TIMEOUT_MS for the scheduler-side watchdog that
+ * force-releases entries no one cancelled.
+ * @param trx_handle The handle of the aborting transaction.
+ */
+void isofuzz_trx_cancel_pending(isofuzz_trx_t trx_handle);
+
 /**
  * @brief Notifies the library that a transaction has ended (committed or aborted).
  * The library will clean up any internal state associated with this handle.
@@ -111,6 +191,20 @@ void isofuzz_trx_end(isofuzz_trx_t trx_handle);
  * ========================================================================
  */
 
+/**
+ * @brief Sets the scheduling mode of the calling thread.
+ * In PASSTHROUGH mode, isofuzz_schedule_op() and isofuzz_schedule_data_op()
+ * return immediately after a single wait-free thread-local check — the
+ * thread is never enqueued and pays no epoch latency — while the logging
+ * functions keep recording events for trace completeness. Intended for
+ * DBMS background threads; worker threads should stay in the default
+ * SCHEDULED mode. The mode sticks until changed again, so a thread can
+ * also scope it around a non-fuzzed section.
+ *
+ * @param mode The mode to apply to the calling thread.
+ */
+void isofuzz_set_thread_mode(IsoFuzzThreadMode mode);
+
 /**
  * @brief Submits a request to the scheduler and blocks until released.
  * This function ONLY handles scheduling and does NOT produce any log output.
@@ -120,6 +214,21 @@ void isofuzz_trx_end(isofuzz_trx_t trx_handle);
  */
 void isofuzz_schedule_op(isofuzz_trx_t trx_handle, IsoFuzzSchedulerIntent intent);
 
+/**
+ * @brief Like isofuzz_schedule_op, but also tells the scheduler which data
+ * object the operation targets. With object identity available the scheduler
+ * can release operations on disjoint rows concurrently (ISOFUZZ_RELEASE_K)
+ * and make conflict-aware scheduling decisions. Adapters should prefer this
+ * variant for row-level operations.
+ *
+ * @param trx_handle The handle for the current transaction.
+ * @param intent The purpose of the scheduling request.
+ * @param object The data object the operation is about to act upon. Only
+ *               needs to live for the duration of the call.
+ */
+void isofuzz_schedule_data_op(isofuzz_trx_t trx_handle, IsoFuzzSchedulerIntent intent,
+                              const IsoFuzzObject& object);
+
 /**
  * @brief Logs the details of a specific data operation.
  * This function ONLY handles logging and does NOT block or schedule.
@@ -133,4 +242,120 @@ void isofuzz_schedule_op(isofuzz_trx_t trx_handle, IsoFuzzSchedulerIntent intent
 void isofuzz_log_op(isofuzz_trx_t trx_handle, IsoFuzzOpType op_type,
                     const IsoFuzzObject& object, uint64_t last_writer_trx_id);
 
+/**
+ * @brief Interns a table or column name, returning a stable integer ID.
+ * The first call for a given name takes a lock and (in binary trace mode)
+ * emits a NAME record; subsequent calls for the same name return the same
+ * ID. Intended to be called once per name at adapter startup; pass the
+ * IDs in an IsoFuzzObjectId on the per-op path. Returns 0 for nullptr.
+ *
+ * @param name The name to intern. Copied; need not outlive the call.
+ * @return The interned ID (>= 1), or 0 for nullptr.
+ */
+uint32_t isofuzz_intern_name(const char* name);
+
+/**
+ * @brief Like isofuzz_log_op, but takes pre-interned name IDs. The per-op
+ * path performs no string hashing, copying, or interning-table lookups:
+ * in binary trace mode the IDs are written directly, and in text mode the
+ * names are resolved through a wait-free ID-to-name table.
+ *
+ * @param trx_handle The handle for the current transaction.
+ * @param op_type The specific operation type for logging.
+ * @param object The object being acted upon, with interned name IDs.
+ * @param last_writer_trx_id For READ/UPDATE/DELETE, the ID of the transaction
+ *                           that wrote the version being accessed.
+ */
+void isofuzz_log_op_id(isofuzz_trx_t trx_handle, IsoFuzzOpType op_type,
+                       const IsoFuzzObjectId& object, uint64_t last_writer_trx_id);
+
+#pragma pack(push, 1)
+// Wire-format event record for isofuzz_log_op_raw(). Field-for-field
+// identical to the binary trace record (src/trace_format.h), so in binary
+// trace mode the adapter's bytes go to the logger with nothing but the
+// library-owned fields stamped on top.
+struct IsoFuzzRecord
+{
+  uint8_t record_type;         // Filled by the library; leave 0.
+  uint8_t op_type;             // static_cast<uint8_t>(IsoFuzzOpType).
+  uint8_t has_object;          // 0 = the object fields below are ignored.
+  uint8_t reserved;            // Must be 0.
+  uint64_t seq;                // Filled by the library; leave 0.
+  uint32_t table_id;           // Interned via isofuzz_intern_name().
+  uint32_t column_id;          // 0 = no column.
+  uint64_t thread_id;          // Filled by the library; leave 0.
+  uint64_t trx_id;             // Filled by the library; leave 0.
+  uint64_t row_identifier;
+  uint64_t last_writer_trx_id; // Emitted exactly as given.
+};
+#pragma pack(pop)
+
+/**
+ * @brief Zero-copy logging: emits a record the adapter filled in place.
+ * Adapters whose internal structs already hold table/row/writer IDs as
+ * integers fill an IsoFuzzRecord directly and skip IsoFuzzObject
+ * construction and all per-field conversion; the library's role shrinks
+ * to stamping the sequence number and identity fields and handing the
+ * bytes to the logger. Unlike the cooked entry points, last_writer_trx_id
+ * is emitted exactly as given for every op type.
+ *
+ * @param trx_handle The handle for the current transaction.
+ * @param record The record to emit. Read once; need not outlive the call.
+ */
+void isofuzz_log_op_raw(isofuzz_trx_t trx_handle, const IsoFuzzRecord* record);
+
+/*
+ * ========================================================================
+ * Compile-time filtering
+ * ========================================================================
+ * Campaigns that only care about a subset of events (e.g. only writes)
+ * can filter at the adapter callsite instead of paying the call, the
+ * handle lookup, and a scheduling round trip for events discarded
+ * offline. The _if variants take a bitmask template parameter; when the
+ * intent/op at the callsite is a compile-time constant the check folds
+ * away entirely, and a mask of 0 compiles the instrumentation out. These
+ * compose with the runtime allowlist (ISOFUZZ_INTENT_ALLOW,
+ * ISOFUZZ_OP_ALLOW, ISOFUZZ_TABLE_ALLOW), which is applied inside the
+ * non-template entry points with a single mask test before any other
+ * work.
+ */
+
+constexpr uint32_t isofuzz_intent_bit(IsoFuzzSchedulerIntent intent)
+{
+  return 1u << static_cast<uint32_t>(intent);
+}
+
+constexpr uint32_t isofuzz_op_bit(IsoFuzzOpType op_type)
+{
+  return 1u << static_cast<uint32_t>(op_type);
+}
+
+// Schedules only when the intent is in IntentMask (a bitwise-or of
+// isofuzz_intent_bit values). Filtered-out calls cost one folded branch.
+template <uint32_t IntentMask>
+inline void isofuzz_schedule_op_if(isofuzz_trx_t trx_handle, IsoFuzzSchedulerIntent intent)
+{
+  if ((IntentMask & isofuzz_intent_bit(intent)) == 0) return;
+  isofuzz_schedule_op(trx_handle, intent);
+}
+
+template <uint32_t IntentMask>
+inline void isofuzz_schedule_data_op_if(isofuzz_trx_t trx_handle,
+                                        IsoFuzzSchedulerIntent intent,
+                                        const IsoFuzzObject& object)
+{
+  if ((IntentMask & isofuzz_intent_bit(intent)) == 0) return;
+  isofuzz_schedule_data_op(trx_handle, intent, object);
+}
+
+// Logs only when the op type is in OpMask (a bitwise-or of isofuzz_op_bit
+// values).
+template <uint32_t OpMask>
+inline void isofuzz_log_op_if(isofuzz_trx_t trx_handle, IsoFuzzOpType op_type,
+                              const IsoFuzzObject& object, uint64_t last_writer_trx_id)
+{
+  if ((OpMask & isofuzz_op_bit(op_type)) == 0) return;
+  isofuzz_log_op(trx_handle, op_type, object, last_writer_trx_id);
+}
+
 #endif // ISOFUZZ_H
@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+
+"""
+Decoder for the IsoFuzz binary trace format (ISOFUZZ_BINARY_TRACE=1).
+
+Reconstructs the exact tab-separated text lines the default text mode would
+have produced, so the rest of the offline pipeline (translate_to_elle.py)
+consumes binary traces unchanged:
+
+    decode_trace.py trace.bin | ./translate_to_elle.py /dev/stdin out.edn
+
+The format is described in src/trace_format.h: a 5-byte header ("IFZB" +
+version byte) followed by records tagged with a one-byte type. NAME records
+map interned ids to table/column strings; EVENT records are fixed-width and
+refer to names by id. Because the async logger may reorder records across
+threads, a NAME record can appear *after* the first EVENT that uses its id,
+so decoding is done in two passes: collect all names, then decode events.
+A header may also appear mid-stream when multiple runs append to one file.
+"""
+
+import argparse
+import struct
+import sys
+
+MAGIC = b"IFZB"
+SUPPORTED_VERSION = 2
+
+REC_EVENT = 1
+REC_NAME = 2
+
+# struct IsoFuzzBinEvent, little-endian, packed (52 bytes incl. type tag)
+EVENT_STRUCT = struct.Struct("<BBBxQIIQQQQ")
+# struct IsoFuzzBinName (7 bytes incl. type tag), followed by `length` bytes
+NAME_STRUCT = struct.Struct("<BIH")
+
+# Must match the order of enum class IsoFuzzOpType in include/isofuzz.h
+OP_TYPE_NAMES = ["READ", "UPDATE", "INSERT", "DELETE", "PROMOTE", "BEGIN", "COMMIT"]
+
+
+def parse_arguments():
+    parser = argparse.ArgumentParser(
+        description="Decode an IsoFuzz binary trace into the text trace format."
+    )
+    parser.add_argument(
+        "trace_file",
+        type=str,
+        help="Path to the binary trace file."
+    )
+    parser.add_argument(
+        "-o", "--output",
+        type=str,
+        default=None,
+        help="Output path for the decoded text trace (default: stdout)."
+    )
+    return parser.parse_args()
+
+
+def iter_records(data):
+    """Yields (record_type, payload_tuple) for every record in the stream."""
+    offset = 0
+    size = len(data)
+    while offset < size:
+        tag = data[offset]
+        if data[offset:offset + len(MAGIC)] == MAGIC:
+            version = data[offset + len(MAGIC)]
+            if version != SUPPORTED_VERSION:
+                print(f"Error: unsupported trace version {version}", file=sys.stderr)
+                sys.exit(1)
+            offset += len(MAGIC) + 1
+        elif tag == REC_EVENT:
+            if offset + EVENT_STRUCT.size > size:
+                break  # Truncated tail (e.g., unclean shutdown); stop cleanly.
+            yield REC_EVENT, EVENT_STRUCT.unpack_from(data, offset)
+            offset += EVENT_STRUCT.size
+        elif tag == REC_NAME:
+            if offset + NAME_STRUCT.size > size:
+                break
+            _, name_id, length = NAME_STRUCT.unpack_from(data, offset)
+            start = offset + NAME_STRUCT.size
+            if start + length > size:
+                break
+            yield REC_NAME, (name_id, data[start:start + length])
+            offset = start + length
+        else:
+            print(f"Error: unknown record type {tag} at offset {offset}", file=sys.stderr)
+            sys.exit(1)
+
+
+def main():
+    args = parse_arguments()
+
+    try:
+        with open(args.trace_file, "rb") as f:
+            data = f.read()
+    except OSError as e:
+        print(f"Error: cannot read '{args.trace_file}': {e}", file=sys.stderr)
+        sys.exit(1)
+
+    # Pass 1: build the interned-name table.
+    names = {0: None}
+    for rec_type, payload in iter_records(data):
+        if rec_type == REC_NAME:
+            name_id, raw = payload
+            names[name_id] = raw.decode("utf-8", errors="replace")
+
+    out = open(args.output, "w") if args.output else sys.stdout
+
+    # Pass 2: decode events into the 8-field TSV lines of the text mode.
+    for rec_type, payload in iter_records(data):
+        if rec_type != REC_EVENT:
+            continue
+        (_, op_type, has_object, seq, table_id, column_id,
+         thread_id, trx_id, row_identifier, last_writer) = payload
+
+        op_name = OP_TYPE_NAMES[op_type] if op_type < len(OP_TYPE_NAMES) else "UNKNOWN"
+        if has_object:
+            table = names.get(table_id) or "N/A"
+            column = names.get(column_id) or "N/A"
+            row = str(row_identifier)
+        else:
+            table = column = row = "N/A"
+
+        out.write(f"{seq}\t{thread_id}\t{trx_id}\t{op_name}\t{table}\t{column}\t{row}\t{last_writer}\n")
+
+    if out is not sys.stdout:
+        out.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+
+"""
+Schedule-space coverage report for ISOFUZZ_COVERAGE_FILE output.
+
+The scheduler appends one line per completed epoch:
+
+    <shard> <epoch> <fingerprint-hex>
+
+where the fingerprint is a 64-bit FNV-1a hash of the epoch's release
+order (the released (lib_id, intent) sequence). Two epochs with the same
+fingerprint almost certainly exercised the same interleaving, so the
+fraction of *new* fingerprints over time shows whether a campaign is
+still exploring or has saturated:
+
+    schedule_coverage.py coverage.txt [more-coverage-files...]
+
+Multiple files (e.g. one per run of a campaign) are analyzed as one
+stream in argument order. The novelty curve splits the stream into ten
+equal slices and reports how many fingerprints in each slice were seen
+for the first time — a campaign whose last slices show ~0% novelty is
+done and the hardware can be reassigned.
+"""
+
+import argparse
+import sys
+
+
+def parse_arguments():
+    parser = argparse.ArgumentParser(
+        description="Report unique-schedule coverage from IsoFuzz coverage files."
+    )
+    parser.add_argument(
+        "coverage_files",
+        nargs="+",
+        help="Coverage file(s) written via ISOFUZZ_COVERAGE_FILE, in campaign order.",
+    )
+    parser.add_argument(
+        "--slices",
+        type=int,
+        default=10,
+        help="Number of slices in the novelty-over-time curve (default 10).",
+    )
+    return parser.parse_args()
+
+
+def read_fingerprints(paths):
+    """Yields (shard, epoch, fingerprint) tuples in file/line order."""
+    for path in paths:
+        with open(path, "r") as handle:
+            for line_number, line in enumerate(handle, start=1):
+                fields = line.split()
+                if len(fields) != 3:
+                    print(
+                        f"warning: {path}:{line_number}: malformed line skipped",
+                        file=sys.stderr,
+                    )
+                    continue
+                try:
+                    yield int(fields[0]), int(fields[1]), int(fields[2], 16)
+                except ValueError:
+                    print(
+                        f"warning: {path}:{line_number}: malformed line skipped",
+                        file=sys.stderr,
+                    )
+
+
+def main():
+    args = parse_arguments()
+    entries = list(read_fingerprints(args.coverage_files))
+    if not entries:
+        print("no coverage entries found", file=sys.stderr)
+        return 1
+
+    total = len(entries)
+    seen = set()
+    # first_seen[i] is True when entry i's fingerprint was new at that point.
+    first_seen = []
+    for _, _, fingerprint in entries:
+        is_new = fingerprint not in seen
+        first_seen.append(is_new)
+        seen.add(fingerprint)
+
+    unique = len(seen)
+    shards = len({shard for shard, _, _ in entries})
+
+    print(f"epochs:             {total}")
+    print(f"scheduler shards:   {shards}")
+    print(f"unique schedules:   {unique}")
+    print(f"uniqueness ratio:   {unique / total:.3f}")
+    # With a 64-bit hash, accidental collisions are negligible below ~2^32
+    # distinct schedules; repeats are therefore genuinely repeated orders.
+    print(f"repeat rate:        {(total - unique) / total:.3f}")
+
+    slices = max(1, min(args.slices, total))
+    print(f"\nnovelty over time ({slices} slices):")
+    for s in range(slices):
+        lo = s * total // slices
+        hi = (s + 1) * total // slices
+        if hi <= lo:
+            continue
+        new_count = sum(first_seen[lo:hi])
+        ratio = new_count / (hi - lo)
+        bar = "#" * round(ratio * 40)
+        print(f"  slice {s + 1:2d}: {new_count:6d}/{hi - lo:<6d} new ({ratio:6.1%}) {bar}")
+
+    tail = first_seen[(slices - 1) * total // slices:]
+    if tail and sum(tail) == 0:
+        print("\nno new schedules in the final slice: campaign looks saturated.")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
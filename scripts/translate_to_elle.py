@@ -61,79 +61,94 @@ def process_log_file(trace_file_path):
     event_time_counter = 0
 
     try:
+        # Newer traces carry an explicit global sequence number as the first
+        # field, which lets the library emit records out of order (per-thread
+        # buffers, async writer). Sort by it before processing; legacy 7-field
+        # traces fall back to file order.
+        events = []
         with open(trace_file_path, 'r') as f:
-            for line in f:
-                event_time_counter += 1
+            for line_no, line in enumerate(f, start=1):
                 line = line.strip()
                 if not line: continue
-                parts = line.strip().split('\t')
-                if len(parts) != 7: continue
-
-                _thread_id, trx_id_str, event_type, table, _col, row_str, last_writer_id_str = parts
-
-                try:
-                    trx_id = int(trx_id_str)
-                    row_id = int(row_str) if row_str != "N/A" else None
-                    last_writer_id = int(last_writer_id_str)
-                except (ValueError, TypeError):
-                    continue
-
-                # Handle PROMOTE as a special directive to update our ID map
-                if event_type == "PROMOTE":
-                    old_id, new_id = last_writer_id, trx_id
-                    id_map[old_id] = new_id
-                    if old_id in transactions:
-                        transactions[new_id] = transactions.pop(old_id)
-                    continue
-
-                # Resolve the canonical transaction ID for the current event
-                canonical_id = id_map.get(trx_id, trx_id)
-
-                if event_type == "BEGIN":
-                    if transactions[canonical_id]['begin_time'] == -1:
-                        transactions[canonical_id]['begin_time'] = event_time_counter
-                elif event_type == "COMMIT":
-                    if canonical_id in transactions:
-                        transactions[canonical_id]['end_time'] = event_time_counter
-                elif event_type in ("READ", "UPDATE", "DELETE", "INSERT"):
-                    if table == "N/A" or row_id is None: continue
-
-                    # The object of atomicity is the row.
-                    obj_id = (table, row_id)
-
-                    # Get the correct prefix of the version history for this operation.
-                    full_history = object_versions.get(obj_id, [])
-                    observed_history = []
-                    if event_type in ("READ", "UPDATE", "DELETE"):
-                        try:
-                            # A read observes the history UP TO the version it read.
-                            idx = full_history.index(last_writer_id)
-                            observed_history = full_history[:idx + 1]
-                        except ValueError:
-                            # This fixes the empty-read bug. If the version isn't in our
-                            # tracked history, it must be the initial version of the object.
-                            if last_writer_id != 0:
-                                observed_history = [last_writer_id]
-                    # For INSERT, observed_history remains an empty list, which is correct.
-
-                    op_data = {
-                        'type': event_type,
-                        'obj_id': obj_id,
-                        'observed_history': observed_history,
-                        'value': canonical_id
-                    }
-
-                    if event_type in ("INSERT", "UPDATE", "DELETE"):
-                        # --- "WRITE-ONCE" COALESCING LOGIC ---
-                        # Only append the logical write operation if we haven't already for this object.
-                        if obj_id not in transactions[canonical_id]['written_objects']:
-                            transactions[canonical_id]['ops'].append(op_data)
-                            transactions[canonical_id]['written_objects'].add(obj_id)
-
-                        # Always update the global version history to reflect the physical write.
-                        object_versions[obj_id].append(canonical_id)
-                    else:  # It's a READ
+                parts = line.split('\t')
+                if len(parts) == 8:
+                    try:
+                        seq = int(parts[0])
+                    except ValueError:
+                        continue
+                    events.append((seq, parts[1:]))
+                elif len(parts) == 7:
+                    events.append((line_no, parts))
+        events.sort(key=lambda e: e[0])
+
+        for seq, parts in events:
+            event_time_counter += 1
+
+            _thread_id, trx_id_str, event_type, table, _col, row_str, last_writer_id_str = parts
+
+            try:
+                trx_id = int(trx_id_str)
+                row_id = int(row_str) if row_str != "N/A" else None
+                last_writer_id = int(last_writer_id_str)
+            except (ValueError, TypeError):
+                continue
+
+            # Handle PROMOTE as a special directive to update our ID map
+            if event_type == "PROMOTE":
+                old_id, new_id = last_writer_id, trx_id
+                id_map[old_id] = new_id
+                if old_id in transactions:
+                    transactions[new_id] = transactions.pop(old_id)
+                continue
+
+            # Resolve the canonical transaction ID for the current event
+            canonical_id = id_map.get(trx_id, trx_id)
+
+            if event_type == "BEGIN":
+                if transactions[canonical_id]['begin_time'] == -1:
+                    transactions[canonical_id]['begin_time'] = event_time_counter
+            elif event_type == "COMMIT":
+                if canonical_id in transactions:
+                    transactions[canonical_id]['end_time'] = event_time_counter
+            elif event_type in ("READ", "UPDATE", "DELETE", "INSERT"):
+                if table == "N/A" or row_id is None: continue
+
+                # The object of atomicity is the row.
+                obj_id = (table, row_id)
+
+                # Get the correct prefix of the version history for this operation.
+                full_history = object_versions.get(obj_id, [])
+                observed_history = []
+                if event_type in ("READ", "UPDATE", "DELETE"):
+                    try:
+                        # A read observes the history UP TO the version it read.
+                        idx = full_history.index(last_writer_id)
+                        observed_history = full_history[:idx + 1]
+                    except ValueError:
+                        # This fixes the empty-read bug. If the version isn't in our
+                        # tracked history, it must be the initial version of the object.
+                        if last_writer_id != 0:
+                            observed_history = [last_writer_id]
+                # For INSERT, observed_history remains an empty list, which is correct.
+
+                op_data = {
+                    'type': event_type,
+                    'obj_id': obj_id,
+                    'observed_history': observed_history,
+                    'value': canonical_id
+                }
+
+                if event_type in ("INSERT", "UPDATE", "DELETE"):
+                    # --- "WRITE-ONCE" COALESCING LOGIC ---
+                    # Only append the logical write operation if we haven't already for this object.
+                    if obj_id not in transactions[canonical_id]['written_objects']:
                         transactions[canonical_id]['ops'].append(op_data)
+                        transactions[canonical_id]['written_objects'].add(obj_id)
+
+                    # Always update the global version history to reflect the physical write.
+                    object_versions[obj_id].append(canonical_id)
+                else:  # It's a READ
+                    transactions[canonical_id]['ops'].append(op_data)
 
     except FileNotFoundError:
         print(f"Error: Trace file not found at '{trace_file_path}'", file=sys.stderr)
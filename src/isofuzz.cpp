@@ -2,19 +2,30 @@
 #include "isofuzz_ctx.h"
 #include "logger.h"
 #include "scheduler.h"
+#include "stats.h"
+#include "trace_format.h"
 
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
 #include <sstream>
 #include <thread>
+#include <unordered_map>
+#include <unordered_set>
 
 // --- IsoFuzzContext Implementation ---
 
 isofuzz_trx_t IsoFuzzContext::begin_trx()
 {
-  std::lock_guard lock(m_trx_map_mutex);
   uint64_t id = next_lib_id.fetch_add(1, std::memory_order_relaxed);
   auto trx = std::make_unique<IsoFuzzTrxImpl>(id, std::this_thread::get_id());
   IsoFuzzTrxImpl* trx_ptr = trx.get();
-  m_transactions[id] = std::move(trx);
+  TrxMapShard& shard = shard_for(id);
+  std::lock_guard lock(shard.mtx);
+  shard.map[id] = std::move(trx);
   return reinterpret_cast<isofuzz_trx_t>(trx_ptr);
 }
 
@@ -22,8 +33,9 @@ void IsoFuzzContext::end_trx(isofuzz_trx_t handle)
 {
   if (!handle) return;
   IsoFuzzTrxImpl* trx = reinterpret_cast<IsoFuzzTrxImpl*>(handle);
-  std::lock_guard lock(m_trx_map_mutex);
-  m_transactions.erase(trx->lib_id);
+  TrxMapShard& shard = shard_for(trx->lib_id);
+  std::lock_guard lock(shard.mtx);
+  shard.map.erase(trx->lib_id);
 }
 
 IsoFuzzTrxImpl* IsoFuzzContext::get_trx(isofuzz_trx_t handle)
@@ -37,10 +49,253 @@ IsoFuzzTrxImpl* IsoFuzzContext::get_trx(isofuzz_trx_t handle)
 static void log_generic_op(isofuzz_trx_t trx_handle, IsoFuzzOpType op_type,
                            const IsoFuzzObject* object, uint64_t last_writer_trx_id);
 
+/*
+ * ========================================================================
+ * Binary Trace Mode (ISOFUZZ_BINARY_TRACE=1)
+ * ========================================================================
+ * Table/column names are interned: each distinct name gets a uint32_t id
+ * and a NAME record on first sight, so EVENT records are fixed-width and
+ * carry no strings. See src/trace_format.h for the record layout and
+ * scripts/decode_trace.py for the reference decoder.
+ */
+static bool g_binary_trace = false;
+
+// Global event sequence number, stamped as the first field of every trace
+// record. With an explicit sequence the on-disk emission order no longer
+// matters — per-thread buffers, the async writer, and ring dumps may all
+// reorder records, and offline analysis merge-sorts by seq.
+static std::atomic<uint64_t> g_event_seq(1);
+
+/*
+ * ========================================================================
+ * Runtime event allowlist
+ * ========================================================================
+ * The compile-time _if templates in the header filter at the callsite;
+ * these masks filter inside the non-template entry points for campaigns
+ * that narrow their focus per run. All three are parsed once at
+ * isofuzz_init() and immutable afterwards, so the hot-path checks are a
+ * read-only mask test — one AND and one branch — with no atomics and no
+ * cache-line bouncing. Unset variables leave everything enabled.
+ *
+ *   ISOFUZZ_INTENT_ALLOW  comma list of begin,commit,abort,read,write
+ *   ISOFUZZ_OP_ALLOW      comma list of read,update,insert,delete,
+ *                         promote,begin,commit
+ *   ISOFUZZ_TABLE_ALLOW   comma list of table names
+ */
+static constexpr size_t MAX_INTERNED_NAMES = 65536;
+
+static uint32_t g_intent_allow_mask = ~0u;
+static uint32_t g_op_allow_mask = ~0u;
+static bool g_table_filter_active = false;
+static std::unordered_set<std::string> g_table_allow_names; // Read-only after init.
+
+// Bitmap over interned table ids, maintained by intern_trace_name(), so
+// the ID-based hot path checks table membership with one bit test.
+static uint64_t g_table_allow_bits[MAX_INTERNED_NAMES / 64];
+
+static bool table_id_allowed(uint32_t table_id)
+{
+  if (!g_table_filter_active) return true;
+  if (table_id >= MAX_INTERNED_NAMES) return false;
+  return (g_table_allow_bits[table_id >> 6] >> (table_id & 63)) & 1u;
+}
+
+static bool table_name_allowed(const char* table_name)
+{
+  if (!g_table_filter_active || table_name == nullptr) return true;
+  return g_table_allow_names.count(table_name) != 0;
+}
+
+// Splits a comma-separated env value and ors together the bit each token
+// maps to; returns ~0u (everything allowed) when the variable is unset.
+static uint32_t parse_allow_mask(const char* env_name,
+                                 uint32_t (*bit_for_token)(const std::string&))
+{
+  const char* value = std::getenv(env_name);
+  if (value == nullptr) return ~0u;
+  uint32_t mask = 0;
+  std::stringstream ss(value);
+  std::string token;
+  while (std::getline(ss, token, ','))
+  {
+    if (!token.empty())
+    {
+      mask |= bit_for_token(token);
+    }
+  }
+  return mask;
+}
+
+static uint32_t intent_bit_for_token(const std::string& token)
+{
+  if (token == "begin") return isofuzz_intent_bit(IsoFuzzSchedulerIntent::TXN_BEGIN);
+  if (token == "commit") return isofuzz_intent_bit(IsoFuzzSchedulerIntent::TXN_COMMIT);
+  if (token == "abort") return isofuzz_intent_bit(IsoFuzzSchedulerIntent::TXN_ABORT);
+  if (token == "read") return isofuzz_intent_bit(IsoFuzzSchedulerIntent::OP_READ);
+  if (token == "write") return isofuzz_intent_bit(IsoFuzzSchedulerIntent::OP_WRITE);
+  std::cerr << "IsoFuzz WARNING: unknown intent '" << token
+    << "' in ISOFUZZ_INTENT_ALLOW." << std::endl;
+  return 0;
+}
+
+static uint32_t op_bit_for_token(const std::string& token)
+{
+  if (token == "read") return isofuzz_op_bit(IsoFuzzOpType::READ);
+  if (token == "update") return isofuzz_op_bit(IsoFuzzOpType::WRITE_UPDATE);
+  if (token == "insert") return isofuzz_op_bit(IsoFuzzOpType::WRITE_INSERT);
+  if (token == "delete") return isofuzz_op_bit(IsoFuzzOpType::WRITE_DELETE);
+  if (token == "promote") return isofuzz_op_bit(IsoFuzzOpType::TXN_PROMOTE);
+  if (token == "begin") return isofuzz_op_bit(IsoFuzzOpType::TXN_BEGIN);
+  if (token == "commit") return isofuzz_op_bit(IsoFuzzOpType::TXN_COMMIT);
+  std::cerr << "IsoFuzz WARNING: unknown op '" << token
+    << "' in ISOFUZZ_OP_ALLOW." << std::endl;
+  return 0;
+}
+
+static void init_allowlists()
+{
+  g_intent_allow_mask = parse_allow_mask("ISOFUZZ_INTENT_ALLOW", intent_bit_for_token);
+  g_op_allow_mask = parse_allow_mask("ISOFUZZ_OP_ALLOW", op_bit_for_token);
+  const char* tables = std::getenv("ISOFUZZ_TABLE_ALLOW");
+  if (tables != nullptr)
+  {
+    std::stringstream ss(tables);
+    std::string token;
+    while (std::getline(ss, token, ','))
+    {
+      if (!token.empty())
+      {
+        g_table_allow_names.insert(token);
+      }
+    }
+    g_table_filter_active = true;
+  }
+}
+
+/*
+ * ========================================================================
+ * Transaction-local buffering (ISOFUZZ_TRX_BUFFER=1)
+ * ========================================================================
+ * Under high-contention workloads most events belong to transactions that
+ * later abort and are filtered offline anyway. In buffered mode each
+ * event is appended to the transaction's own arena instead of the logger,
+ * and the whole arena is handed over in one batched call at commit — one
+ * logger synchronization per transaction instead of per operation.
+ * Transactions that end without committing either drop their buffer (the
+ * default) or emit it (ISOFUZZ_TRX_BUFFER_ABORTS=emit). Records carry the
+ * global sequence number, so offline sorting by seq reconstructs the true
+ * order regardless of when buffers flush.
+ */
+static bool g_trx_buffer_mode = false;
+static bool g_emit_abort_buffers = false;
+
+// Appends one encoded record to the transaction's arena in buffered mode,
+// or sends it straight to the logger otherwise.
+static void emit_record(IsoFuzzTrxImpl* trx, const void* data, size_t len)
+{
+  if (g_trx_buffer_mode)
+  {
+    trx->log_buffer.append(static_cast<const char*>(data), len);
+    return;
+  }
+  logger_log_record(data, len);
+}
+
+static void emit_line(IsoFuzzTrxImpl* trx, const std::string& line)
+{
+  if (g_trx_buffer_mode)
+  {
+    trx->log_buffer.append(line);
+    trx->log_buffer.push_back('\n');
+    return;
+  }
+  logger_log_line(line);
+}
+
+// Hands a transaction's buffered events to the logger in one call.
+static void flush_trx_buffer(IsoFuzzTrxImpl* trx)
+{
+  if (!trx->log_buffer.empty())
+  {
+    logger_log_record(trx->log_buffer.data(), trx->log_buffer.size());
+    trx->log_buffer.clear();
+  }
+}
+
+static std::mutex g_intern_mutex;
+static std::unordered_map<std::string, uint32_t> g_intern_ids;
+static uint32_t g_next_intern_id = 1; // 0 is reserved for "no name"
+
+// Reverse (id -> name) table for the ID-based logging path. Interned name
+// strings live in g_intern_storage (a deque, so references are stable) and
+// are published here by index; readers do a single relaxed atomic load and
+// never take g_intern_mutex, so id-to-name resolution is wait-free.
+static std::deque<std::string> g_intern_storage;
+static std::atomic<const char*> g_intern_names[MAX_INTERNED_NAMES];
+
+// Wait-free lookup of an interned name. Returns nullptr for id 0, an
+// out-of-range id, or an id this process never interned.
+static const char* intern_name_for_id(uint32_t id)
+{
+  if (id == 0 || id >= MAX_INTERNED_NAMES) return nullptr;
+  return g_intern_names[id].load(std::memory_order_acquire);
+}
+
+// Returns the interned id for a name, emitting a NAME record the first
+// time the name is seen (binary mode only). Accepts nullptr and returns 0.
+static uint32_t intern_trace_name(const char* name)
+{
+  if (name == nullptr) return 0;
+  std::lock_guard lock(g_intern_mutex);
+  auto it = g_intern_ids.find(name);
+  if (it != g_intern_ids.end())
+  {
+    return it->second;
+  }
+  uint32_t id = g_next_intern_id++;
+  g_intern_ids.emplace(name, id);
+  if (id < MAX_INTERNED_NAMES)
+  {
+    g_intern_storage.emplace_back(name);
+    g_intern_names[id].store(g_intern_storage.back().c_str(),
+                             std::memory_order_release);
+    if (g_table_filter_active && g_table_allow_names.count(name) != 0)
+    {
+      g_table_allow_bits[id >> 6] |= 1ull << (id & 63);
+    }
+  }
+
+  if (g_binary_trace)
+  {
+    size_t name_len = std::strlen(name);
+    IsoFuzzBinName rec{};
+    rec.record_type = ISOFUZZ_REC_NAME;
+    rec.id = id;
+    rec.length = static_cast<uint16_t>(name_len);
+    std::string payload(reinterpret_cast<const char*>(&rec), sizeof(rec));
+    payload.append(name, name_len);
+    logger_log_record(payload.data(), payload.size());
+  }
+  return id;
+}
 
 void isofuzz_init()
 {
+  init_allowlists();
   logger_init();
+  const char* binary_str = std::getenv("ISOFUZZ_BINARY_TRACE");
+  g_binary_trace = (binary_str != nullptr && binary_str[0] == '1');
+  const char* trx_buffer_str = std::getenv("ISOFUZZ_TRX_BUFFER");
+  g_trx_buffer_mode = (trx_buffer_str != nullptr && trx_buffer_str[0] == '1');
+  const char* aborts_str = std::getenv("ISOFUZZ_TRX_BUFFER_ABORTS");
+  g_emit_abort_buffers = (aborts_str != nullptr && std::strcmp(aborts_str, "emit") == 0);
+  if (g_binary_trace)
+  {
+    char header[sizeof(ISOFUZZ_TRACE_MAGIC) + 1];
+    std::memcpy(header, ISOFUZZ_TRACE_MAGIC, sizeof(ISOFUZZ_TRACE_MAGIC));
+    header[sizeof(ISOFUZZ_TRACE_MAGIC)] = ISOFUZZ_TRACE_VERSION;
+    logger_log_record(header, sizeof(header));
+  }
   scheduler_init();
 }
 
@@ -50,6 +305,34 @@ void isofuzz_shutdown()
   logger_shutdown();
 }
 
+void isofuzz_flush()
+{
+  logger_flush();
+}
+
+void isofuzz_dump_trace()
+{
+  logger_dump_trace();
+}
+
+void isofuzz_get_stats(IsoFuzzStats* stats)
+{
+  if (!stats) return;
+  stats->requests = isofuzz_stats::requests.get();
+  stats->releases = isofuzz_stats::releases.get();
+  stats->batched_releases = isofuzz_stats::batched_releases.get();
+  stats->spin_wakeups = isofuzz_stats::spin_wakeups.get();
+  stats->parked_wakeups = isofuzz_stats::parked_wakeups.get();
+  stats->epochs = isofuzz_stats::epochs.get();
+  stats->total_batch = isofuzz_stats::total_batch.get();
+  stats->max_batch = isofuzz_stats::max_batch.get();
+  stats->collecting_ns = isofuzz_stats::collecting_ns.get();
+  stats->draining_ns = isofuzz_stats::draining_ns.get();
+  stats->events_logged = isofuzz_stats::events_logged.get();
+  stats->cancellations = isofuzz_stats::cancellations.get();
+  stats->timeout_releases = isofuzz_stats::timeout_releases.get();
+}
+
 isofuzz_trx_t isofuzz_trx_begin()
 {
   // 1. Create the internal handle.
@@ -76,6 +359,17 @@ void isofuzz_trx_commit(isofuzz_trx_t trx_handle)
 
   // 2. Log the COMMIT event.
   log_generic_op(trx_handle, IsoFuzzOpType::TXN_COMMIT, nullptr, 0);
+
+  // 3. In buffered mode the transaction's events (including the COMMIT
+  // just logged) reach the logger here, in a single batched call.
+  if (g_trx_buffer_mode)
+  {
+    IsoFuzzTrxImpl* trx = IsoFuzzContext::getInstance().get_trx(trx_handle);
+    if (trx)
+    {
+      flush_trx_buffer(trx);
+    }
+  }
 }
 
 void isofuzz_trx_promote(isofuzz_trx_t trx_handle, uint64_t new_dbms_id)
@@ -86,8 +380,34 @@ void isofuzz_trx_promote(isofuzz_trx_t trx_handle, uint64_t new_dbms_id)
   log_generic_op(trx_handle, IsoFuzzOpType::TXN_PROMOTE, nullptr, trx->lib_id);
 }
 
+void isofuzz_trx_cancel_pending(isofuzz_trx_t trx_handle)
+{
+  IsoFuzzTrxImpl* trx = IsoFuzzContext::getInstance().get_trx(trx_handle);
+  if (!trx) return;
+  scheduler_cancel_pending(trx->lib_id, trx->pending_request);
+}
+
 void isofuzz_trx_end(isofuzz_trx_t trx_handle)
 {
+  // A non-empty buffer here means the transaction ended without
+  // committing: drop it (the default — aborted-transaction events are
+  // offline noise) or emit it when configured to keep everything.
+  if (g_trx_buffer_mode)
+  {
+    IsoFuzzTrxImpl* trx = IsoFuzzContext::getInstance().get_trx(trx_handle);
+    if (trx)
+    {
+      if (g_emit_abort_buffers)
+      {
+        flush_trx_buffer(trx);
+      }
+      else
+      {
+        trx->log_buffer.clear();
+      }
+    }
+  }
+
   // This function is now ONLY for resource cleanup.
   IsoFuzzContext::getInstance().end_trx(trx_handle);
 }
@@ -97,11 +417,34 @@ void isofuzz_trx_end(isofuzz_trx_t trx_handle)
  * Data Operation API
  * ========================================================================
  */
+// The calling thread's scheduling mode. Read on every schedule call with a
+// plain thread-local load, so passthrough threads pay one wait-free check
+// and nothing else.
+static thread_local IsoFuzzThreadMode t_thread_mode = IsoFuzzThreadMode::SCHEDULED;
+
+void isofuzz_set_thread_mode(IsoFuzzThreadMode mode)
+{
+  t_thread_mode = mode;
+}
+
 void isofuzz_schedule_op(isofuzz_trx_t trx_handle, IsoFuzzSchedulerIntent intent)
 {
+  if ((g_intent_allow_mask & isofuzz_intent_bit(intent)) == 0) return;
+  if (t_thread_mode == IsoFuzzThreadMode::PASSTHROUGH) return;
+  IsoFuzzTrxImpl* trx = IsoFuzzContext::getInstance().get_trx(trx_handle);
+  if (!trx) return;
+  scheduler_request(trx->lib_id, intent, nullptr, &trx->pending_request);
+}
+
+void isofuzz_schedule_data_op(isofuzz_trx_t trx_handle, IsoFuzzSchedulerIntent intent,
+                              const IsoFuzzObject& object)
+{
+  if ((g_intent_allow_mask & isofuzz_intent_bit(intent)) == 0) return;
+  if (!table_name_allowed(object.table_name)) return;
+  if (t_thread_mode == IsoFuzzThreadMode::PASSTHROUGH) return;
   IsoFuzzTrxImpl* trx = IsoFuzzContext::getInstance().get_trx(trx_handle);
   if (!trx) return;
-  scheduler_request(trx->lib_id, intent);
+  scheduler_request(trx->lib_id, intent, &object, &trx->pending_request);
 }
 
 void isofuzz_log_op(isofuzz_trx_t trx_handle, IsoFuzzOpType op_type,
@@ -110,6 +453,147 @@ void isofuzz_log_op(isofuzz_trx_t trx_handle, IsoFuzzOpType op_type,
   log_generic_op(trx_handle, op_type, &object, last_writer_trx_id);
 }
 
+uint32_t isofuzz_intern_name(const char* name)
+{
+  return intern_trace_name(name);
+}
+
+void isofuzz_log_op_id(isofuzz_trx_t trx_handle, IsoFuzzOpType op_type,
+                       const IsoFuzzObjectId& object, uint64_t last_writer_trx_id)
+{
+  if ((g_op_allow_mask & isofuzz_op_bit(op_type)) == 0) return;
+  if (!table_id_allowed(object.table_id)) return;
+  IsoFuzzTrxImpl* trx = IsoFuzzContext::getInstance().get_trx(trx_handle);
+  if (!trx) return;
+
+  uint64_t effective_trx_id = trx->dbms_id.load(std::memory_order_relaxed);
+  if (effective_trx_id == 0)
+  {
+    effective_trx_id = trx->lib_id;
+  }
+
+  uint64_t last_field = 0;
+  if (op_type == IsoFuzzOpType::TXN_PROMOTE || op_type == IsoFuzzOpType::READ ||
+    op_type == IsoFuzzOpType::WRITE_UPDATE || op_type == IsoFuzzOpType::WRITE_DELETE)
+  {
+    last_field = last_writer_trx_id;
+  }
+
+  uint64_t seq = g_event_seq.fetch_add(1, std::memory_order_relaxed);
+  isofuzz_stats::events_logged.inc();
+
+  if (g_binary_trace)
+  {
+    // The IDs drop straight into the fixed-width record; no interning-table
+    // lookup, hashing, or string copy happens on this path.
+    IsoFuzzBinEvent rec{};
+    rec.record_type = ISOFUZZ_REC_EVENT;
+    rec.op_type = static_cast<uint8_t>(op_type);
+    rec.has_object = 1;
+    rec.seq = seq;
+    rec.thread_id = std::hash<std::thread::id>{}(trx->thread_id);
+    rec.trx_id = effective_trx_id;
+    rec.table_id = object.table_id;
+    rec.column_id = object.column_id;
+    rec.row_identifier = object.row_identifier;
+    rec.last_writer_trx_id = last_field;
+    emit_record(trx, &rec, sizeof(rec));
+    return;
+  }
+
+  // Text mode resolves names through the wait-free reverse table so the
+  // output stays identical to the string-based API. An unknown id (never
+  // interned in this process) falls back to printing the raw id.
+  const char* table_name = intern_name_for_id(object.table_id);
+  const char* column_name = intern_name_for_id(object.column_id);
+
+  std::stringstream ss;
+  ss << seq << "\t"
+    << trx->thread_id << "\t"
+    << effective_trx_id << "\t"
+    << op_type_to_string(op_type) << "\t";
+
+  if (table_name)
+  {
+    ss << table_name << "\t";
+  }
+  else
+  {
+    ss << "id:" << object.table_id << "\t";
+  }
+  ss << (column_name ? column_name : "N/A") << "\t"
+    << object.row_identifier << "\t"
+    << last_field;
+  emit_line(trx, ss.str());
+}
+
+static_assert(sizeof(IsoFuzzRecord) == sizeof(IsoFuzzBinEvent),
+              "IsoFuzzRecord must stay layout-identical to the binary trace record.");
+
+void isofuzz_log_op_raw(isofuzz_trx_t trx_handle, const IsoFuzzRecord* record)
+{
+  if (!record) return;
+  if ((g_op_allow_mask & isofuzz_op_bit(static_cast<IsoFuzzOpType>(record->op_type))) == 0) return;
+  if (record->has_object && !table_id_allowed(record->table_id)) return;
+  IsoFuzzTrxImpl* trx = IsoFuzzContext::getInstance().get_trx(trx_handle);
+  if (!trx) return;
+
+  uint64_t effective_trx_id = trx->dbms_id.load(std::memory_order_relaxed);
+  if (effective_trx_id == 0)
+  {
+    effective_trx_id = trx->lib_id;
+  }
+
+  uint64_t seq = g_event_seq.fetch_add(1, std::memory_order_relaxed);
+  isofuzz_stats::events_logged.inc();
+
+  if (g_binary_trace)
+  {
+    // The record IS the wire format: one memcpy of the adapter's bytes,
+    // then the library-owned fields are stamped on top. No per-field
+    // conversion happens here regardless of how the adapter built it.
+    IsoFuzzBinEvent rec;
+    std::memcpy(&rec, record, sizeof(rec));
+    rec.record_type = ISOFUZZ_REC_EVENT;
+    rec.reserved = 0;
+    rec.seq = seq;
+    rec.thread_id = std::hash<std::thread::id>{}(trx->thread_id);
+    rec.trx_id = effective_trx_id;
+    emit_record(trx, &rec, sizeof(rec));
+    return;
+  }
+
+  // Text mode formats from the interned ids, same as isofuzz_log_op_id.
+  std::stringstream ss;
+  ss << seq << "\t"
+    << trx->thread_id << "\t"
+    << effective_trx_id << "\t"
+    << op_type_to_string(static_cast<IsoFuzzOpType>(record->op_type)) << "\t";
+
+  if (record->has_object)
+  {
+    const char* table_name = intern_name_for_id(record->table_id);
+    const char* column_name = intern_name_for_id(record->column_id);
+    if (table_name)
+    {
+      ss << table_name << "\t";
+    }
+    else
+    {
+      ss << "id:" << record->table_id << "\t";
+    }
+    ss << (column_name ? column_name : "N/A") << "\t"
+      << record->row_identifier << "\t";
+  }
+  else
+  {
+    ss << "N/A\tN/A\tN/A\t";
+  }
+
+  ss << record->last_writer_trx_id;
+  emit_line(trx, ss.str());
+}
+
 /*
  * ========================================================================
  * Internal Logging Helper
@@ -118,17 +602,54 @@ void isofuzz_log_op(isofuzz_trx_t trx_handle, IsoFuzzOpType op_type,
 static void log_generic_op(isofuzz_trx_t trx_handle, IsoFuzzOpType op_type,
                            const IsoFuzzObject* object, uint64_t last_writer_trx_id)
 {
+  if ((g_op_allow_mask & isofuzz_op_bit(op_type)) == 0) return;
+  // Object-less events (BEGIN/COMMIT/PROMOTE) always pass the table
+  // filter: transaction boundaries are needed to interpret any trace.
+  if (object != nullptr && !table_name_allowed(object->table_name)) return;
   IsoFuzzTrxImpl* trx = IsoFuzzContext::getInstance().get_trx(trx_handle);
   if (!trx) return;
 
-  std::stringstream ss;
   uint64_t effective_trx_id = trx->dbms_id.load(std::memory_order_relaxed);
   if (effective_trx_id == 0)
   {
     effective_trx_id = trx->lib_id;
   }
 
-  ss << trx->thread_id << "\t"
+  // The last field carries the last-writer id only for version-observing
+  // events; PROMOTE repurposes it to log the old temporary id.
+  uint64_t last_field = 0;
+  if (op_type == IsoFuzzOpType::TXN_PROMOTE || op_type == IsoFuzzOpType::READ ||
+    op_type == IsoFuzzOpType::WRITE_UPDATE || op_type == IsoFuzzOpType::WRITE_DELETE)
+  {
+    last_field = last_writer_trx_id;
+  }
+
+  uint64_t seq = g_event_seq.fetch_add(1, std::memory_order_relaxed);
+  isofuzz_stats::events_logged.inc();
+
+  if (g_binary_trace)
+  {
+    IsoFuzzBinEvent rec{};
+    rec.record_type = ISOFUZZ_REC_EVENT;
+    rec.op_type = static_cast<uint8_t>(op_type);
+    rec.has_object = (object != nullptr) ? 1 : 0;
+    rec.seq = seq;
+    rec.thread_id = std::hash<std::thread::id>{}(trx->thread_id);
+    rec.trx_id = effective_trx_id;
+    if (object)
+    {
+      rec.table_id = intern_trace_name(object->table_name);
+      rec.column_id = intern_trace_name(object->column_name);
+      rec.row_identifier = object->row_identifier;
+    }
+    rec.last_writer_trx_id = last_field;
+    emit_record(trx, &rec, sizeof(rec));
+    return;
+  }
+
+  std::stringstream ss;
+  ss << seq << "\t"
+    << trx->thread_id << "\t"
     << effective_trx_id << "\t"
     << op_type_to_string(op_type) << "\t";
 
@@ -143,21 +664,8 @@ static void log_generic_op(isofuzz_trx_t trx_handle, IsoFuzzOpType op_type,
     ss << "N/A\tN/A\tN/A\t";
   }
 
-  if (op_type == IsoFuzzOpType::TXN_PROMOTE)
-  {
-    // For PROMOTE, the last_writer_trx_id field is repurposed to log the old temp ID.
-    ss << last_writer_trx_id;
-  }
-  else if (op_type == IsoFuzzOpType::READ || op_type == IsoFuzzOpType::WRITE_UPDATE || op_type ==
-    IsoFuzzOpType::WRITE_DELETE)
-  {
-    ss << last_writer_trx_id;
-  }
-  else
-  {
-    ss << "0";
-  }
-  logger_log_line(ss.str());
+  ss << last_field;
+  emit_line(trx, ss.str());
 }
 
 
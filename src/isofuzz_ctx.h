@@ -3,6 +3,7 @@
 
 #include "isofuzz.h" // For public enums and IsoFuzzObject
 
+#include <array>
 #include <atomic>
 #include <cstdint>
 #include <memory>
@@ -11,6 +12,8 @@
 #include <thread>
 #include <unordered_map>
 
+struct SchedRequestNode; // Defined in scheduler.cpp.
+
 // The internal, concrete implementation of the opaque IsoFuzzTrx handle.
 struct IsoFuzzTrxImpl
 {
@@ -24,6 +27,18 @@ struct IsoFuzzTrxImpl
   // The thread ID that began this transaction.
   const std::thread::id thread_id;
 
+  // Transaction-local event arena (ISOFUZZ_TRX_BUFFER=1): log records
+  // accumulate here and are handed to the logger in one batched call at
+  // commit. Grows geometrically with the string; touched only by the
+  // transaction's own thread, so it needs no lock.
+  std::string log_buffer;
+
+  // The scheduling request this transaction is currently blocked on, or
+  // null. Published by scheduler_request() for the duration of the wait so
+  // isofuzz_trx_cancel_pending() can release the waiter directly, even
+  // while the request still sits in a shard's inbox.
+  std::atomic<SchedRequestNode*> pending_request{nullptr};
+
   IsoFuzzTrxImpl(uint64_t lib_id, std::thread::id thread_id)
     : lib_id(lib_id), dbms_id(0), thread_id(thread_id)
   {
@@ -56,8 +71,24 @@ private:
 
   ~IsoFuzzContext() = default;
 
-  std::mutex m_trx_map_mutex;
-  std::unordered_map<uint64_t, std::unique_ptr<IsoFuzzTrxImpl>> m_transactions;
+  // The transaction map is sharded by lib_id so concurrent begin/end from
+  // many connection threads contend on different mutexes. lib_ids are
+  // assigned sequentially, so consecutive transactions land on different
+  // shards by construction.
+  struct TrxMapShard
+  {
+    std::mutex mtx;
+    std::unordered_map<uint64_t, std::unique_ptr<IsoFuzzTrxImpl>> map;
+  };
+
+  static constexpr size_t NUM_TRX_SHARDS = 64; // Power of two for cheap masking.
+
+  TrxMapShard& shard_for(uint64_t lib_id)
+  {
+    return m_shards[lib_id & (NUM_TRX_SHARDS - 1)];
+  }
+
+  std::array<TrxMapShard, NUM_TRX_SHARDS> m_shards;
   std::atomic<uint64_t> next_lib_id;
 };
 
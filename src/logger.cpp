@@ -1,54 +1,679 @@
 #include "logger.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <memory>
 #include <mutex>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#if defined(ISOFUZZ_HAVE_ZLIB)
+#include <zlib.h>
+#endif
 
 static std::ofstream g_file;
 static std::mutex g_file_lock;
 static std::ostream* g_out_ptr = &std::cout;
 
+/*
+ * ========================================================================
+ * Asynchronous mode (ISOFUZZ_ASYNC_LOG=1)
+ * ========================================================================
+ * Worker threads append lines to one of a small number of sharded in-memory
+ * buffers (shard chosen by thread id), holding only the shard's own mutex
+ * for the duration of a string append. A dedicated writer thread
+ * periodically swaps each shard's buffer for an empty one and performs a
+ * single large write to the output stream. The stream is only flushed at
+ * logger_shutdown() or on an explicit logger_flush().
+ */
+struct LogShard
+{
+  std::mutex mtx;
+  std::string buf;
+};
+
+static constexpr size_t NUM_LOG_SHARDS = 16;
+static std::array<LogShard, NUM_LOG_SHARDS> g_log_shards;
+
+static bool g_async_mode = false;
+static std::thread g_writer_thread;
+static std::atomic<bool> g_writer_running(false);
+
+// Serializes drains between the writer thread and explicit flush callers.
+static std::mutex g_writer_mutex;
+static std::condition_variable g_writer_cv;
+static const std::chrono::milliseconds WRITER_INTERVAL_MS(10);
+
+/*
+ * ========================================================================
+ * Ring-buffer mode (ISOFUZZ_TRACE_MODE=ring)
+ * ========================================================================
+ * For crash triage only the tail of the trace matters. In ring mode each
+ * thread writes events into its own preallocated circular segment
+ * (ISOFUZZ_RING_BYTES each) with no locks and no I/O; the segments are
+ * dumped to OUT_FILE only at shutdown, from a fatal-signal handler, or via
+ * isofuzz_dump_trace(). Output goes through a raw fd with ::write so the
+ * dump path is async-signal-safe. A dump is a best-effort snapshot: a
+ * segment whose owner is mid-append may contribute one torn record at the
+ * wrap seam, which offline tooling skips.
+ */
+struct RingSegment
+{
+  std::unique_ptr<char[]> data;
+  size_t cap = 0;
+  std::atomic<size_t> pos{0};
+  std::atomic<bool> wrapped{false};
+  RingSegment* next = nullptr;
+};
+
+static bool g_ring_mode = false;
+static size_t RING_SEGMENT_BYTES = 16u << 20; // Per-thread segment size.
+static int g_ring_fd = STDOUT_FILENO;
+
+// Lock-free registration list so the signal handler can walk the segments
+// without taking a mutex. Segments are intentionally never freed: a thread
+// that exited may still hold trace tail we want in the dump.
+static std::atomic<RingSegment*> g_ring_segments(nullptr);
+
+static RingSegment* ring_segment_for_thread()
+{
+  static thread_local RingSegment* seg = nullptr;
+  if (seg == nullptr)
+  {
+    seg = new RingSegment();
+    seg->cap = RING_SEGMENT_BYTES;
+    seg->data = std::make_unique<char[]>(seg->cap);
+    seg->next = g_ring_segments.load(std::memory_order_relaxed);
+    while (!g_ring_segments.compare_exchange_weak(seg->next, seg,
+                                                  std::memory_order_release,
+                                                  std::memory_order_relaxed))
+    {
+    }
+  }
+  return seg;
+}
+
+static void ring_append(const char* bytes, size_t len)
+{
+  RingSegment* seg = ring_segment_for_thread();
+  if (len > seg->cap)
+  {
+    bytes += len - seg->cap;
+    len = seg->cap;
+  }
+  size_t pos = seg->pos.load(std::memory_order_relaxed);
+  if (pos + len > seg->cap)
+  {
+    // Wrap to the start; old data between 0 and len is overwritten.
+    seg->wrapped.store(true, std::memory_order_relaxed);
+    pos = 0;
+  }
+  std::memcpy(seg->data.get() + pos, bytes, len);
+  seg->pos.store(pos + len, std::memory_order_release);
+}
+
+// Async-signal-safe full write.
+static void fd_write_all(int fd, const char* data, size_t len)
+{
+  while (len > 0)
+  {
+    ssize_t n = ::write(fd, data, len);
+    if (n <= 0)
+    {
+      return;
+    }
+    data += n;
+    len -= static_cast<size_t>(n);
+  }
+}
+
+// Dumps every thread's segment (oldest data first within a segment).
+// Async-signal-safe; also the shutdown path in ring mode.
+static void ring_dump()
+{
+  for (RingSegment* seg = g_ring_segments.load(std::memory_order_acquire);
+       seg != nullptr; seg = seg->next)
+  {
+    size_t pos = seg->pos.load(std::memory_order_acquire);
+    if (seg->wrapped.load(std::memory_order_relaxed))
+    {
+      fd_write_all(g_ring_fd, seg->data.get() + pos, seg->cap - pos);
+    }
+    fd_write_all(g_ring_fd, seg->data.get(), pos);
+  }
+}
+
+static void ring_signal_handler(int sig)
+{
+  ring_dump();
+  std::signal(sig, SIG_DFL);
+  std::raise(sig);
+}
+
+/*
+ * ========================================================================
+ * Memory-mapped mode (ISOFUZZ_TRACE_MODE=mmap)
+ * ========================================================================
+ * For tens-of-GB traces the per-write syscall and stdio buffering of the
+ * stream path dominate. In mmap mode the output file is preallocated in
+ * large extents (ftruncate + mmap, ISOFUZZ_MMAP_EXTENT_BYTES each) and a
+ * record write is: one relaxed fetch_add to claim a file offset, then a
+ * plain memcpy into the mapping. The kernel writes pages back on its own
+ * schedule; msync happens only at shutdown or on an explicit flush, so no
+ * syscall ever appears on the worker-visible path. Requires OUT_FILE (a
+ * terminal cannot be mapped); the file is truncated on init and trimmed to
+ * the exact trace length at shutdown.
+ */
+static bool g_mmap_mode = false;
+static size_t MMAP_EXTENT_BYTES = 64u << 20;
+static constexpr size_t MMAP_MAX_EXTENTS = 4096; // 256 GiB at the default size.
+
+static int g_mmap_fd = -1;
+static std::atomic<size_t> g_mmap_pos(0); // Next unclaimed file offset.
+static std::atomic<char*> g_mmap_extent_base[MMAP_MAX_EXTENTS];
+static std::mutex g_mmap_grow_mutex; // Serializes extent creation only.
+static off_t g_mmap_file_size = 0;   // High-water mark; under the grow mutex.
+
+// Maps extent `idx`, growing the file first. Called off the common path —
+// once per ISOFUZZ_MMAP_EXTENT_BYTES of trace. Returns nullptr on failure.
+static char* mmap_map_extent(size_t idx)
+{
+  std::lock_guard lock(g_mmap_grow_mutex);
+  char* base = g_mmap_extent_base[idx].load(std::memory_order_acquire);
+  if (base != nullptr)
+  {
+    return base; // Another writer mapped it while we waited.
+  }
+  // Extents can be mapped out of order: offsets are claimed with fetch_add
+  // before any copy, so a thread whose range ends extent N can be
+  // descheduled while later claimants cross into and map N+1. Growing is
+  // therefore gated on a high-water mark — an unconditional ftruncate
+  // would shrink the file below an already-mapped higher extent, discard
+  // its written bytes, and turn its next memcpy into SIGBUS.
+  off_t new_size = static_cast<off_t>((idx + 1) * MMAP_EXTENT_BYTES);
+  if (new_size > g_mmap_file_size)
+  {
+    if (::ftruncate(g_mmap_fd, new_size) != 0)
+    {
+      return nullptr;
+    }
+    g_mmap_file_size = new_size;
+  }
+  void* mapping = ::mmap(nullptr, MMAP_EXTENT_BYTES, PROT_READ | PROT_WRITE,
+                         MAP_SHARED, g_mmap_fd,
+                         static_cast<off_t>(idx * MMAP_EXTENT_BYTES));
+  if (mapping == MAP_FAILED)
+  {
+    return nullptr;
+  }
+  base = static_cast<char*>(mapping);
+  g_mmap_extent_base[idx].store(base, std::memory_order_release);
+  return base;
+}
+
+// Copies into the mapping(s) at an already-claimed offset. A record that
+// straddles an extent boundary is copied piecewise, since adjacent extents
+// are not virtually contiguous.
+static void mmap_copy_at(size_t offset, const char* bytes, size_t len)
+{
+  while (len > 0)
+  {
+    size_t idx = offset / MMAP_EXTENT_BYTES;
+    if (idx >= MMAP_MAX_EXTENTS)
+    {
+      static std::atomic<bool> warned(false);
+      if (!warned.exchange(true))
+      {
+        std::cerr << "IsoFuzz WARNING: mmap trace exceeded "
+          << MMAP_MAX_EXTENTS << " extents; further output dropped. "
+          << "Raise ISOFUZZ_MMAP_EXTENT_BYTES." << std::endl;
+      }
+      return;
+    }
+    char* base = g_mmap_extent_base[idx].load(std::memory_order_acquire);
+    if (base == nullptr)
+    {
+      base = mmap_map_extent(idx);
+      if (base == nullptr)
+      {
+        return; // File cannot grow (e.g. disk full); drop the record.
+      }
+    }
+    size_t in_extent = offset % MMAP_EXTENT_BYTES;
+    size_t chunk = std::min(len, MMAP_EXTENT_BYTES - in_extent);
+    std::memcpy(base + in_extent, bytes, chunk);
+    offset += chunk;
+    bytes += chunk;
+    len -= chunk;
+  }
+}
+
+// Claims a file range with one relaxed fetch_add and copies the record
+// into it. Concurrent appenders never interleave within a record because
+// the whole range is reserved up front.
+static void mmap_append(const char* bytes, size_t len)
+{
+  size_t offset = g_mmap_pos.fetch_add(len, std::memory_order_relaxed);
+  mmap_copy_at(offset, bytes, len);
+}
+
+// Line variant: the line and its newline share one reservation, so other
+// threads cannot claim bytes between them.
+static void mmap_append_line(const std::string& line)
+{
+  size_t offset = g_mmap_pos.fetch_add(line.size() + 1, std::memory_order_relaxed);
+  mmap_copy_at(offset, line.data(), line.size());
+  mmap_copy_at(offset + line.size(), "\n", 1);
+}
+
+// Asks the kernel to write mapped extents back. MS_ASYNC on explicit
+// flushes (schedule writeback, don't stall the caller), MS_SYNC at
+// shutdown so the trace is durable before the process exits.
+static void mmap_sync(int flags)
+{
+  for (size_t idx = 0; idx < MMAP_MAX_EXTENTS; ++idx)
+  {
+    char* base = g_mmap_extent_base[idx].load(std::memory_order_acquire);
+    if (base == nullptr)
+    {
+      break; // Extents are mapped densely from 0.
+    }
+    ::msync(base, MMAP_EXTENT_BYTES, flags);
+  }
+}
+
+/*
+ * ========================================================================
+ * Compressed output (ISOFUZZ_COMPRESS=1)
+ * ========================================================================
+ * Traces are highly repetitive (the same tables, monotonic IDs), so a
+ * fast streaming codec cuts the I/O that competes with the DBMS's own
+ * log writes by an order of magnitude. Compression runs entirely on the
+ * async writer thread — enabling it implies ISOFUZZ_ASYNC_LOG — and
+ * produces a standard gzip stream in OUT_FILE (read back with zcat).
+ * Built only when zlib is available; incompatible with the ring and mmap
+ * trace modes, which bypass the writer thread.
+ */
+static bool g_compress_mode = false;
+
+#if defined(ISOFUZZ_HAVE_ZLIB)
+static z_stream g_zstream;
+static std::array<char, 256 * 1024> g_zout_buf;
+
+// Feeds bytes through deflate and writes whatever it produces. Runs only
+// under g_writer_mutex (the writer thread, or flush/shutdown callers), so
+// the z_stream needs no locking of its own.
+static void compressed_write(const char* data, size_t len, int flush_mode)
+{
+  g_zstream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+  g_zstream.avail_in = static_cast<uInt>(len);
+  int rc = Z_OK;
+  do
+  {
+    g_zstream.next_out = reinterpret_cast<Bytef*>(g_zout_buf.data());
+    g_zstream.avail_out = static_cast<uInt>(g_zout_buf.size());
+    rc = deflate(&g_zstream, flush_mode);
+    size_t produced = g_zout_buf.size() - g_zstream.avail_out;
+    if (produced > 0)
+    {
+      std::lock_guard lock(g_file_lock);
+      g_out_ptr->write(g_zout_buf.data(), static_cast<std::streamsize>(produced));
+    }
+  } while (g_zstream.avail_in > 0 || g_zstream.avail_out == 0 ||
+    (flush_mode == Z_FINISH && rc != Z_STREAM_END));
+}
+#endif
+
+static size_t this_thread_shard()
+{
+  static thread_local const size_t shard =
+    std::hash<std::thread::id>{}(std::this_thread::get_id()) % NUM_LOG_SHARDS;
+  return shard;
+}
+
+// Swaps every shard's buffer out and writes the contents in large batches.
+// Caller must hold g_writer_mutex.
+static void drain_all_shards()
+{
+  std::string local;
+  for (auto& shard : g_log_shards)
+  {
+    {
+      std::lock_guard lock(shard.mtx);
+      if (shard.buf.empty())
+      {
+        continue;
+      }
+      local.swap(shard.buf);
+    }
+#if defined(ISOFUZZ_HAVE_ZLIB)
+    if (g_compress_mode)
+    {
+      compressed_write(local.data(), local.size(), Z_NO_FLUSH);
+      local.clear();
+      continue;
+    }
+#endif
+    {
+      std::lock_guard lock(g_file_lock);
+      g_out_ptr->write(local.data(), static_cast<std::streamsize>(local.size()));
+    }
+    local.clear();
+  }
+}
+
+static void writer_thread_run()
+{
+  std::unique_lock lock(g_writer_mutex);
+  while (g_writer_running.load(std::memory_order_acquire))
+  {
+    g_writer_cv.wait_for(lock, WRITER_INTERVAL_MS);
+    drain_all_shards();
+  }
+  // Final drain so nothing enqueued before shutdown is lost.
+  drain_all_shards();
+}
+
 void logger_init()
 {
-  std::lock_guard lock(g_file_lock);
-  const char* path = std::getenv("OUT_FILE");
-  if (path)
+  const char* mode_str = std::getenv("ISOFUZZ_TRACE_MODE");
+  g_ring_mode = (mode_str != nullptr && std::strcmp(mode_str, "ring") == 0);
+  g_mmap_mode = (mode_str != nullptr && std::strcmp(mode_str, "mmap") == 0);
+  if (g_mmap_mode)
   {
-    // Close if already open, to handle re-init scenarios
-    if (g_file.is_open())
+    const char* extent_str = std::getenv("ISOFUZZ_MMAP_EXTENT_BYTES");
+    if (extent_str)
+    {
+      try
+      {
+        long bytes = std::stol(extent_str);
+        // Extents must be page-multiples for mmap; 64 KiB is a safe floor.
+        if (bytes >= 65536)
+        {
+          MMAP_EXTENT_BYTES = static_cast<size_t>(bytes);
+        }
+      }
+      catch (const std::exception&)
+      {
+      }
+    }
+    const char* path = std::getenv("OUT_FILE");
+    if (path)
     {
-      g_file.close();
+      g_mmap_fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
     }
-    g_file.open(path, std::ios::out | std::ios::app);
-    if (g_file.is_open())
+    if (g_mmap_fd < 0)
     {
-      g_out_ptr = &g_file;
+      std::cerr << "IsoFuzz WARNING: mmap trace mode requires a writable "
+        << "OUT_FILE; falling back to stream logging." << std::endl;
+      g_mmap_mode = false;
     }
     else
     {
-      g_out_ptr = &std::cerr; // Log to stderr if file opening fails
-      std::cerr << "IsoFuzz WARNING: Could not open OUT_FILE=" << path << ". Logging to stderr." << std::endl;
+      g_mmap_pos.store(0, std::memory_order_relaxed);
+      g_mmap_file_size = 0; // O_TRUNC above; no writers exist yet.
+      return;
     }
   }
-  else
+  if (g_ring_mode)
+  {
+    const char* ring_bytes_str = std::getenv("ISOFUZZ_RING_BYTES");
+    if (ring_bytes_str)
+    {
+      try
+      {
+        long bytes = std::stol(ring_bytes_str);
+        if (bytes > 0)
+        {
+          RING_SEGMENT_BYTES = static_cast<size_t>(bytes);
+        }
+      }
+      catch (const std::exception&)
+      {
+      }
+    }
+    const char* path = std::getenv("OUT_FILE");
+    if (path)
+    {
+      int fd = ::open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+      if (fd >= 0)
+      {
+        g_ring_fd = fd;
+      }
+      else
+      {
+        g_ring_fd = STDERR_FILENO;
+        std::cerr << "IsoFuzz WARNING: Could not open OUT_FILE=" << path << ". Dumping to stderr." << std::endl;
+      }
+    }
+    // Dump the in-memory trace before the process dies on a fatal signal.
+    std::signal(SIGSEGV, ring_signal_handler);
+    std::signal(SIGBUS, ring_signal_handler);
+    std::signal(SIGABRT, ring_signal_handler);
+    return;
+  }
+
   {
-    g_out_ptr = &std::cout;
+    std::lock_guard lock(g_file_lock);
+    const char* path = std::getenv("OUT_FILE");
+    if (path)
+    {
+      // Close if already open, to handle re-init scenarios
+      if (g_file.is_open())
+      {
+        g_file.close();
+      }
+      // Always binary: harmless for text lines, required for binary records.
+      g_file.open(path, std::ios::out | std::ios::app | std::ios::binary);
+      if (g_file.is_open())
+      {
+        g_out_ptr = &g_file;
+      }
+      else
+      {
+        g_out_ptr = &std::cerr; // Log to stderr if file opening fails
+        std::cerr << "IsoFuzz WARNING: Could not open OUT_FILE=" << path << ". Logging to stderr." << std::endl;
+      }
+    }
+    else
+    {
+      g_out_ptr = &std::cout;
+    }
+  }
+
+  const char* async_str = std::getenv("ISOFUZZ_ASYNC_LOG");
+  g_async_mode = (async_str != nullptr && async_str[0] == '1');
+
+  const char* compress_str = std::getenv("ISOFUZZ_COMPRESS");
+  if (compress_str != nullptr && compress_str[0] == '1')
+  {
+#if defined(ISOFUZZ_HAVE_ZLIB)
+    // Compression lives on the writer thread, so it requires async mode.
+    g_async_mode = true;
+    std::memset(&g_zstream, 0, sizeof(g_zstream));
+    if (deflateInit2(&g_zstream, Z_BEST_SPEED, Z_DEFLATED,
+                     15 + 16 /* gzip framing */, 8, Z_DEFAULT_STRATEGY) == Z_OK)
+    {
+      g_compress_mode = true;
+    }
+    else
+    {
+      std::cerr << "IsoFuzz WARNING: deflateInit failed; writing "
+        << "uncompressed." << std::endl;
+    }
+#else
+    std::cerr << "IsoFuzz WARNING: ISOFUZZ_COMPRESS=1 but the library was "
+      << "built without zlib; writing uncompressed." << std::endl;
+#endif
+  }
+
+  if (g_async_mode && !g_writer_running.exchange(true, std::memory_order_acq_rel))
+  {
+    g_writer_thread = std::thread(writer_thread_run);
   }
 }
 
 void logger_shutdown()
 {
+  if (g_mmap_mode)
+  {
+    mmap_sync(MS_SYNC);
+    size_t final_size = g_mmap_pos.load(std::memory_order_relaxed);
+    for (size_t idx = 0; idx < MMAP_MAX_EXTENTS; ++idx)
+    {
+      char* base = g_mmap_extent_base[idx].exchange(nullptr, std::memory_order_acq_rel);
+      if (base == nullptr)
+      {
+        break;
+      }
+      ::munmap(base, MMAP_EXTENT_BYTES);
+    }
+    // Trim the preallocated zero tail so the file ends exactly at the
+    // last record.
+    if (::ftruncate(g_mmap_fd, static_cast<off_t>(final_size)) != 0)
+    {
+      std::cerr << "IsoFuzz WARNING: could not trim mmap trace file." << std::endl;
+    }
+    ::close(g_mmap_fd);
+    g_mmap_fd = -1;
+    g_mmap_mode = false;
+    return;
+  }
+  if (g_ring_mode)
+  {
+    ring_dump();
+    if (g_ring_fd != STDOUT_FILENO && g_ring_fd != STDERR_FILENO)
+    {
+      ::close(g_ring_fd);
+      g_ring_fd = STDOUT_FILENO;
+    }
+    return;
+  }
+  if (g_writer_running.exchange(false, std::memory_order_acq_rel))
+  {
+    g_writer_cv.notify_one();
+    if (g_writer_thread.joinable())
+    {
+      g_writer_thread.join();
+    }
+  }
+#if defined(ISOFUZZ_HAVE_ZLIB)
+  if (g_compress_mode)
+  {
+    // The writer thread has drained and exited; finish the gzip stream so
+    // the trailer (size + CRC) is written.
+    std::lock_guard lock(g_writer_mutex);
+    compressed_write(nullptr, 0, Z_FINISH);
+    deflateEnd(&g_zstream);
+    g_compress_mode = false;
+  }
+#endif
   std::lock_guard lock(g_file_lock);
+  g_out_ptr->flush();
   if (g_file.is_open())
   {
-    g_file.flush();
     g_file.close();
   }
   g_out_ptr = &std::cout;
 }
 
+void logger_dump_trace()
+{
+  if (g_ring_mode)
+  {
+    ring_dump();
+  }
+  else
+  {
+    logger_flush();
+  }
+}
+
+void logger_flush()
+{
+  if (g_mmap_mode)
+  {
+    mmap_sync(MS_ASYNC); // Schedule writeback without stalling the caller.
+    return;
+  }
+  if (g_ring_mode)
+  {
+    return; // Ring mode only writes on dump.
+  }
+  if (g_async_mode)
+  {
+    std::lock_guard lock(g_writer_mutex);
+    drain_all_shards();
+#if defined(ISOFUZZ_HAVE_ZLIB)
+    if (g_compress_mode)
+    {
+      // Sync-flush so everything logged so far is decompressible now.
+      compressed_write(nullptr, 0, Z_SYNC_FLUSH);
+    }
+#endif
+  }
+  std::lock_guard lock(g_file_lock);
+  g_out_ptr->flush();
+}
+
 void logger_log_line(const std::string& line)
 {
+  if (g_mmap_mode)
+  {
+    mmap_append_line(line);
+    return;
+  }
+  if (g_ring_mode)
+  {
+    ring_append(line.data(), line.size());
+    ring_append("\n", 1);
+    return;
+  }
+  if (g_async_mode)
+  {
+    LogShard& shard = g_log_shards[this_thread_shard()];
+    std::lock_guard lock(shard.mtx);
+    shard.buf.append(line);
+    shard.buf.push_back('\n');
+    return;
+  }
+  std::lock_guard lock(g_file_lock);
+  *g_out_ptr << line << '\n';
+}
+
+void logger_log_record(const void* data, size_t len)
+{
+  const char* bytes = static_cast<const char*>(data);
+  if (g_mmap_mode)
+  {
+    mmap_append(bytes, len);
+    return;
+  }
+  if (g_ring_mode)
+  {
+    ring_append(bytes, len);
+    return;
+  }
+  if (g_async_mode)
+  {
+    LogShard& shard = g_log_shards[this_thread_shard()];
+    std::lock_guard lock(shard.mtx);
+    shard.buf.append(bytes, len);
+    return;
+  }
   std::lock_guard lock(g_file_lock);
-  *g_out_ptr << line << std::endl;
+  g_out_ptr->write(bytes, static_cast<std::streamsize>(len));
 }
@@ -1,10 +1,21 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
+#include <cstddef>
 #include <string>
 
 void logger_init();
 void logger_shutdown();
+void logger_flush();
+
+// In ring mode, writes the current contents of every thread's in-memory
+// segment to the output fd (async-signal-safe). In stream modes this is
+// equivalent to logger_flush().
+void logger_dump_trace();
 void logger_log_line(const std::string& line);
 
+// Appends raw bytes to the trace without any newline handling. Used by the
+// binary trace format; binary-safe in both sync and async modes.
+void logger_log_record(const void* data, size_t len);
+
 #endif // LOGGER_H
@@ -1,165 +1,959 @@
 #include "scheduler.h"
+#include "stats.h"
 
 #include <assert.h>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <algorithm>
 #include <mutex>
-#include <queue>
 #include <random>
+#include <sstream>
 #include <string>
 #include <thread>
 #include <unordered_map>
 #include <vector>
 
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 // State for a single waiting transaction thread.
-// The TrxWaitInfo object is now a plain C++ object. Its lifetime will be
-// managed manually by the requesting thread.
+//
+// Release is a two-stage handshake: the waiter first spins on the atomic
+// is_ready flag, and only if the release does not arrive within the spin
+// budget does it set `parked` and fall back to blocking on the condition
+// variable. The releasing side always stores is_ready first and only takes
+// the mutex/notifies when it observes a parked waiter, so a spinning waiter
+// is released with a plain atomic store and no futex round trip. Both flags
+// use seq_cst so the park/release races resolve safely (at least one side
+// always sees the other's write).
 struct TrxWaitInfo
 {
   std::mutex mtx;
   std::condition_variable cv;
-  bool is_ready = false;
+  std::atomic<bool> is_ready{false};
+  std::atomic<bool> parked{false};
 };
 
-// The scheduler queue holds pairs of <priority, library_trx_id>.
-using TrxPriority = std::pair<int, uint64_t>;
+// Number of spin iterations before a waiter parks on its condition
+// variable. Configurable via ISOFUZZ_SPIN_CYCLES; 0 disables spinning.
+static long SPIN_CYCLES = 4096;
+
+static inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield" ::: "memory");
+#else
+  std::this_thread::yield();
+#endif
+}
+
+// Publishes readiness to a waiter. Cheap (one store) when the waiter is
+// still spinning; takes the waiter's mutex and notifies only when parked.
+static void release_waiter(TrxWaitInfo* wait_info)
+{
+  wait_info->is_ready.store(true, std::memory_order_seq_cst);
+  if (wait_info->parked.load(std::memory_order_seq_cst))
+  {
+    // Lock/unlock pairs with the waiter's cv.wait so the notify cannot be
+    // lost between its predicate check and going to sleep.
+    { std::lock_guard lock(wait_info->mtx); }
+    wait_info->cv.notify_one();
+  }
+}
 
-struct CompareTrxPriority
+// Blocks the calling worker until release_waiter() is invoked on its node.
+static void await_release(TrxWaitInfo* wait_info)
 {
-  bool operator()(const TrxPriority& a, const TrxPriority& b) const
+  for (long i = 0; i < SPIN_CYCLES; ++i)
   {
-    return a.first > b.first; // Min-heap on priority
+    if (wait_info->is_ready.load(std::memory_order_acquire))
+    {
+      isofuzz_stats::spin_wakeups.inc();
+      return;
+    }
+    cpu_relax();
   }
+
+  isofuzz_stats::parked_wakeups.inc();
+  wait_info->parked.store(true, std::memory_order_seq_cst);
+  std::unique_lock lock(wait_info->mtx);
+  wait_info->cv.wait(lock, [wait_info] {
+    return wait_info->is_ready.load(std::memory_order_seq_cst);
+  });
+}
+
+// One epoch-batch entry: a pair of <priority, library_trx_id>.
+using TrxPriority = std::pair<int, uint64_t>;
+
+// A single node in the lock-free MPSC request inbox. It carries everything
+// the scheduler thread needs in one piece: the priority entry AND the waiter
+// itself. This replaces both the old mutex-protected pending_requests queue
+// and the producer-side trx_wait_map insertion, so a worker thread enqueues
+// with a single CAS instead of taking two mutexes back-to-back.
+//
+// Each worker thread owns exactly one of these and reuses it for every
+// request: a transaction thread can only have one outstanding scheduling
+// request at a time, so the steady-state hot path performs zero
+// allocations. The node is heap-allocated once per thread and deliberately
+// never freed (the same idiom as the logger's ring segments): blocking in
+// scheduler_request() until release does NOT bound the scheduler's use of
+// the node, because release_waiter() still reads `parked` and may lock
+// `mtx`/notify after its is_ready store, by which time a spin-path waiter
+// can have returned — and, in a thread-per-connection DBMS, exited its
+// thread. A thread_local instance would be destroyed under the scheduler;
+// the leaked heap node stays valid, and a stray late notify against a
+// reused node is benign (cv.wait re-checks its predicate).
+/*
+ * ========================================================================
+ * Request outcomes (release vs. cancellation)
+ * ========================================================================
+ * Every request ends exactly one way: released by the scheduler, or
+ * cancelled by an abort path. The two race — a canceller can target a
+ * request the drain loop is about to release — so each node carries a
+ * single atomic word that both sides claim with a CAS:
+ *
+ *     outcome = (trx_lib_id << 2) | state
+ *
+ * Tagging the word with the lib_id also defends against stale pointers: a
+ * canceller that loaded a pending_request slot just before the node was
+ * released and reused for a different transaction finds the expected
+ * value gone and backs off. A node whose cancellation won is abandoned by
+ * its owner (never reused, intentionally leaked — cancellations are rare
+ * abort-path events) so the scheduler can still read its fields when it
+ * reaches the now-orphaned inbox or batch entry, and skip it.
+ */
+constexpr uint64_t OUTCOME_PENDING = 0;
+constexpr uint64_t OUTCOME_RELEASED = 1;
+constexpr uint64_t OUTCOME_CANCELLED = 2;
+
+static constexpr uint64_t outcome_word(uint64_t trx_lib_id, uint64_t state)
+{
+  return (trx_lib_id << 2) | state;
+}
+
+struct SchedRequestNode
+{
+  int priority = 0;
+  uint64_t trx_lib_id = 0;
+  IsoFuzzSchedulerIntent intent = IsoFuzzSchedulerIntent::OP_READ;
+  // Identity of the object this operation targets, as a hash over
+  // (table_name, row_identifier). Valid only when has_object is true; used
+  // to decide whether two queued operations may be released concurrently.
+  uint64_t object_key = 0;
+  bool has_object = false;
+  // Steady-clock timestamp (ns) of the enqueue, for the liveness watchdog:
+  // entries older than ISOFUZZ_RELEASE_TIMEOUT_MS are force-released.
+  int64_t enqueue_ns = 0;
+  // See "Request outcomes" above. Claimed PENDING -> RELEASED by whichever
+  // scheduler path releases the waiter, PENDING -> CANCELLED by
+  // scheduler_cancel_pending().
+  std::atomic<uint64_t> outcome{0};
+  TrxWaitInfo wait_info;
+  SchedRequestNode* next = nullptr;
 };
 
-// --- NEW: Epoch-based state ---
+// The per-thread reusable request node; allocated on the thread's first
+// request, reset between requests, never freed (see above). Reset to null
+// when a cancellation wins, abandoning the node (see outcome_word()).
+static thread_local SchedRequestNode* t_request_node = nullptr;
+
+// Claims a pending node for release. False means a canceller got there
+// first — the entry is an orphan the caller must skip without releasing.
+static bool claim_for_release(SchedRequestNode* node, uint64_t trx_lib_id)
+{
+  uint64_t expected = outcome_word(trx_lib_id, OUTCOME_PENDING);
+  return node->outcome.compare_exchange_strong(
+    expected, outcome_word(trx_lib_id, OUTCOME_RELEASED),
+    std::memory_order_acq_rel, std::memory_order_acquire);
+}
+
+// True when the node's current request was cancelled. Safe on orphaned
+// nodes: abandonment means the fields can no longer change under us.
+static bool node_cancelled(const SchedRequestNode* node)
+{
+  return node->outcome.load(std::memory_order_acquire) ==
+    outcome_word(node->trx_lib_id, OUTCOME_CANCELLED);
+}
+
 enum class EpochState { COLLECTING, DRAINING };
 
-static std::atomic<EpochState> g_epoch_state(EpochState::COLLECTING);
-static std::chrono::milliseconds EPOCH_DURATION_MS(5);
+/*
+ * ========================================================================
+ * Scheduler shards (ISOFUZZ_SCHED_SHARDS)
+ * ========================================================================
+ * One SchedulerShard is a complete, independent epoch scheduler: its own
+ * thread, inbox, wait map, queue, and epoch counter. With N > 1 shards,
+ * requests are routed by a hash of the table name in the IsoFuzzObject, so
+ * operations on disjoint tables are scheduled concurrently while all
+ * operations on the same table still pass through one serialized release
+ * stream. Requests with no object information always go to shard 0.
+ *
+ * Sharding trades cross-table interleaving coverage for throughput: two
+ * operations on different tables are never ordered against each other by
+ * the scheduler. That is the right trade only for workloads whose
+ * transactions do not span tables, which is why the default stays 1.
+ */
+struct SchedulerShard
+{
+  size_t index = 0;
+  std::thread thread;
+  std::atomic<EpochState> epoch_state{EpochState::COLLECTING};
+
+  // Protects trx_wait_map and queue. After the MPSC inbox change only this
+  // shard's thread and shutdown touch these, but the lock is kept so
+  // shutdown can safely race with a live scheduler.
+  std::mutex global_mutex;
+  std::condition_variable wakeup_cv;
+
+  // The lock-free multi-producer single-consumer inbox. Producers CAS-push
+  // nodes onto the head; the shard thread grabs the whole list with one
+  // exchange at the epoch boundary.
+  std::atomic<SchedRequestNode*> inbox{nullptr};
+
+  // Event-driven collection: instead of sleeping a fixed epoch regardless
+  // of load, the shard sleeps on this condition variable until the first
+  // request arrives, then collects until the epoch elapses OR the
+  // batch-size cap is hit, whichever comes first. Producers only touch the
+  // mutex on the rare empty->non-empty transition (or when they fill the
+  // batch), so the request path stays lock-free in the steady state.
+  std::mutex collector_mutex;
+  std::condition_variable collector_cv;
+  std::atomic<size_t> pending_count{0};
+
+  // Steady-clock timestamp (ns) of the push that made the inbox non-empty,
+  // i.e. the first request of the next epoch's batch. The collection window
+  // is timed from this point rather than from when the shard thread
+  // re-enters COLLECTING, so a batch that started accumulating while the
+  // previous epoch was still draining has its window already (partly or
+  // fully) elapsed — the two phases pipeline instead of strictly
+  // alternating, and drain time no longer extends worst-case wait times.
+  std::atomic<int64_t> first_arrival_ns{0};
+
+  // Map from a transaction's library ID to its pending request node (which
+  // embeds the wait info and the object identity). The map holds non-owning
+  // pointers into the per-thread request nodes; nothing is ever freed
+  // through it. Populated exclusively by the shard thread on inbox drain.
+  std::unordered_map<uint64_t, SchedRequestNode*> trx_wait_map;
+
+  // The current epoch's batch as a flat vector, sorted ascending by
+  // priority once at the epoch boundary and drained by index. The heap
+  // ordering a priority_queue maintains per push/pop is only ever consumed
+  // once per epoch, so a single std::sort over contiguous entries is
+  // strictly cheaper — and the sort happens before the global lock is
+  // taken, so the critical section shrinks to map inserts and a swap.
+  // Entries behind batch_index are already released (or skipped).
+  std::vector<TrxPriority> batch;
+  size_t batch_index = 0;
+
+  uint64_t epoch_counter = 0;
+
+  // This shard's current collection window. Fixed at EPOCH_DURATION_MS
+  // unless the adaptive controller (ISOFUZZ_TARGET_BATCH) is on, in which
+  // case it moves within [EPOCH_MIN, EPOCH_MAX] to hold the target batch
+  // size. Per shard, because shards see independent slices of the load.
+  std::chrono::nanoseconds epoch_duration{0};
+
+  // Exponentially weighted moving average of recent batch sizes, the
+  // controller's input. 0 until the first non-empty epoch.
+  double batch_ewma = 0.0;
+
+  // Running FNV-1a hash over the (lib_id, intent) sequence released this
+  // epoch, written to the coverage file when the epoch's batch completes.
+  uint64_t epoch_fingerprint = 14695981039346656037ull;
+};
+
+static size_t NUM_SCHED_SHARDS = 1;
+static std::vector<std::unique_ptr<SchedulerShard>> g_shards;
+
+/*
+ * ========================================================================
+ * Scheduler CPU placement (ISOFUZZ_SCHED_CPUS)
+ * ========================================================================
+ * On multi-socket hosts a scheduler thread floating across sockets makes
+ * every waiter handshake pay interconnect latency: the TrxWaitInfo cache
+ * lines live on the worker's node (they are thread_local, so first-touch
+ * already places them locally) and bounce whenever the scheduler runs
+ * remotely. Pinning keeps each shard's scheduler on a fixed CPU —
+ * typically one per socket, next to the workers whose tables route to it.
+ * The value is a comma-separated CPU list; shard i is pinned to the i-th
+ * entry (wrapping). Unset = no pinning.
+ */
+static std::vector<int> g_sched_cpus;
+
+static void pin_shard_thread(SchedulerShard& shard)
+{
+#if defined(__linux__)
+  if (g_sched_cpus.empty())
+  {
+    return;
+  }
+  int cpu = g_sched_cpus[shard.index % g_sched_cpus.size()];
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  if (pthread_setaffinity_np(shard.thread.native_handle(), sizeof(set), &set) != 0)
+  {
+    std::cerr << "IsoFuzz WARNING: could not pin scheduler shard "
+      << shard.index << " to CPU " << cpu << "." << std::endl;
+  }
+#else
+  (void)shard;
+#endif
+}
 
-// --- Global Scheduler State ---
-static std::thread scheduler_thread;
 static std::atomic<bool> scheduler_running(false);
+static std::chrono::milliseconds EPOCH_DURATION_MS(5);
+
+// Batch-size cap for one epoch, from ISOFUZZ_MAX_BATCH. 0 = unbounded.
+static size_t MAX_BATCH = 0;
+
+// Print a one-line stats summary to stderr every N epochs
+// (ISOFUZZ_STATS_PERIOD_EPOCHS). 0 = disabled. Only shard 0 prints, so
+// multi-shard runs don't interleave summary lines.
+static uint64_t STATS_PERIOD_EPOCHS = 0;
+
+static void maybe_dump_stats(const SchedulerShard& shard)
+{
+  if (STATS_PERIOD_EPOCHS == 0 || shard.index != 0 ||
+    shard.epoch_counter % STATS_PERIOD_EPOCHS != 0)
+  {
+    return;
+  }
+  uint64_t epochs = isofuzz_stats::epochs.get();
+  uint64_t total = isofuzz_stats::total_batch.get();
+  std::cerr << "IsoFuzz stats: epoch=" << shard.epoch_counter
+    << " requests=" << isofuzz_stats::requests.get()
+    << " releases=" << isofuzz_stats::releases.get()
+    << " avg_batch=" << (epochs ? total / epochs : 0)
+    << " max_batch=" << isofuzz_stats::max_batch.get()
+    << " spin/parked=" << isofuzz_stats::spin_wakeups.get()
+    << "/" << isofuzz_stats::parked_wakeups.get()
+    << " collect_ms=" << isofuzz_stats::collecting_ns.get() / 1000000
+    << " drain_ms=" << isofuzz_stats::draining_ns.get() / 1000000
+    << " epoch_us=" << std::chrono::duration_cast<std::chrono::microseconds>(
+         shard.epoch_duration).count()
+    << std::endl;
+}
+
+// How many pairwise-disjoint operations the DRAINING loop may release at
+// once (ISOFUZZ_RELEASE_K). 1 = the classic fully serial release.
+static size_t RELEASE_K = 1;
+
+/*
+ * ========================================================================
+ * Adaptive epoch duration (ISOFUZZ_TARGET_BATCH)
+ * ========================================================================
+ * A fixed ISOFUZZ_EPOCH_MS is a per-workload tuning exercise, and workload
+ * intensity drifts over a campaign: a window that is too short collects
+ * one or two operations (no meaningful interleaving, pure overhead), one
+ * that is too long craters throughput. When ISOFUZZ_TARGET_BATCH > 0 each
+ * shard runs a closed loop instead: after every epoch the collection
+ * window is scaled by target / observed batch size, clamped to at most 2x
+ * movement per epoch and to [ISOFUZZ_EPOCH_MIN_MS, ISOFUZZ_EPOCH_MAX_MS]
+ * overall. The observed size is an EWMA over recent epochs so one quiet
+ * or bursty epoch does not whipsaw the window; EPOCH_MAX bounds the wait
+ * time any single operation can be held for collection.
+ */
+static size_t TARGET_BATCH = 0; // 0 = fixed window (the default).
+static std::chrono::nanoseconds EPOCH_MIN = std::chrono::milliseconds(1);
+static std::chrono::nanoseconds EPOCH_MAX = std::chrono::milliseconds(100);
+
+// One controller step; called by the shard thread after each epoch with
+// the batch size it just collected.
+static void adapt_epoch_duration(SchedulerShard& shard, size_t batch_size)
+{
+  if (TARGET_BATCH == 0)
+  {
+    return;
+  }
+  shard.batch_ewma = (shard.batch_ewma == 0.0)
+    ? static_cast<double>(batch_size)
+    : shard.batch_ewma * 0.75 + static_cast<double>(batch_size) * 0.25;
+
+  double ratio = static_cast<double>(TARGET_BATCH) / std::max(shard.batch_ewma, 1.0);
+  ratio = std::clamp(ratio, 0.5, 2.0);
+  auto scaled = std::chrono::nanoseconds(
+    static_cast<int64_t>(static_cast<double>(shard.epoch_duration.count()) * ratio));
+  shard.epoch_duration = std::clamp(scaled, EPOCH_MIN, EPOCH_MAX);
+}
 
-// This mutex protects the main scheduler_queue and the trx_wait_map.
-static std::mutex scheduler_global_mutex;
-static std::condition_variable scheduler_wakeup_cv;
+/*
+ * ========================================================================
+ * Liveness watchdog (ISOFUZZ_RELEASE_TIMEOUT_MS)
+ * ========================================================================
+ * Two things can strand a pending entry in long campaigns: the adapter
+ * aborts a transaction whose scheduling request is still queued, or an
+ * instrumented thread dies between enqueue and release. A stranded entry
+ * used to stall its release round (or trip the no-waiter assert) forever.
+ *
+ * The watchdog has two parts. isofuzz_trx_cancel_pending() lets abort
+ * paths remove a transaction's pending request explicitly — its waiter is
+ * released immediately and the orphaned queue entry is skipped when the
+ * drain reaches it. Independently, when ISOFUZZ_RELEASE_TIMEOUT_MS > 0,
+ * any entry that has waited longer than the timeout is force-released
+ * even if the conflict rules would hold it back; that trades strict
+ * release serialization for liveness, so it is off by default and meant
+ * as an emergency valve for multi-day runs.
+ */
+static std::chrono::milliseconds RELEASE_TIMEOUT_MS(0); // 0 = disabled.
 
-// This mutex protects the new pending_requests queue.
-static std::mutex pending_queue_mutex;
-static std::queue<TrxPriority> pending_requests;
+static int64_t steady_now_ns()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// True when the entry has exceeded the release timeout.
+static bool entry_timed_out(const SchedRequestNode* node, int64_t now_ns)
+{
+  return RELEASE_TIMEOUT_MS.count() > 0 &&
+    now_ns - node->enqueue_ns >
+      std::chrono::duration_cast<std::chrono::nanoseconds>(RELEASE_TIMEOUT_MS).count();
+}
+
+/*
+ * ========================================================================
+ * Schedule record/replay
+ * ========================================================================
+ * RANDOM_SEED alone cannot reproduce a run: the contents of each epoch's
+ * batch depend on OS thread timing during collection. Record mode
+ * (ISOFUZZ_SCHEDULE_RECORD=<file>) appends every release decision —
+ * epoch number, lib_id, intent — as the scheduler makes it. Replay mode
+ * (ISOFUZZ_SCHEDULE_REPLAY=<file>) bypasses priorities entirely and
+ * releases waiters in exactly the recorded order, blocking until the
+ * expected transaction arrives. When the recorded schedule is exhausted
+ * the scheduler falls back to normal epoch scheduling.
+ *
+ * A recorded schedule is a single total order, so record/replay require a
+ * single shard; scheduler_init() forces ISOFUZZ_SCHED_SHARDS to 1 (with a
+ * warning) when either mode is requested.
+ */
+struct ReplayEntry
+{
+  uint64_t epoch;
+  uint64_t lib_id;
+  int intent;
+};
+
+static bool g_record_mode = false;
+static std::ofstream g_record_file; // Written only by the (single) shard thread.
+static bool g_replay_mode = false;
+static std::vector<ReplayEntry> g_replay_schedule;
+static size_t g_replay_index = 0;
+
+/*
+ * ========================================================================
+ * Schedule-space coverage (ISOFUZZ_COVERAGE_FILE)
+ * ========================================================================
+ * A week-long campaign is only worth its hardware while it still explores
+ * new interleavings. When a coverage file is configured, each completed
+ * epoch appends one line — shard, epoch number, and a 64-bit FNV-1a
+ * fingerprint of the released (lib_id, intent) sequence — and
+ * scripts/schedule_coverage.py turns those lines into unique-schedule
+ * counts and novelty-over-time curves, so saturated campaigns can be
+ * terminated early. Fingerprinting is two multiplies and two xors per
+ * release; the file write happens once per epoch under a mutex shared by
+ * the (few, slow-cadence) shard threads.
+ */
+static bool g_coverage_mode = false;
+static std::ofstream g_coverage_file;
+static std::mutex g_coverage_mutex;
+
+// Mixes one release decision into the shard's epoch fingerprint.
+static void coverage_mix(SchedulerShard& shard, const SchedRequestNode* node)
+{
+  uint64_t h = shard.epoch_fingerprint;
+  h = (h ^ node->trx_lib_id) * 1099511628211ull;
+  h = (h ^ static_cast<uint64_t>(node->intent)) * 1099511628211ull;
+  shard.epoch_fingerprint = h;
+}
 
-// Map from a transaction's library ID to its personal wait info.
-// Note: The trx_wait_map no longer holds owning unique_ptrs. It now holds
-// non-owning raw pointers. The responsibility for deleting the TrxWaitInfo
-// object now rests entirely with the thread that created it.
-static std::unordered_map<uint64_t, TrxWaitInfo*> trx_wait_map;
+// Writes the completed epoch's fingerprint and resets it (shard thread only).
+static void coverage_flush_epoch(SchedulerShard& shard)
+{
+  {
+    std::lock_guard lock(g_coverage_mutex);
+    g_coverage_file << shard.index << ' ' << shard.epoch_counter << ' '
+      << std::hex << shard.epoch_fingerprint << std::dec << '\n';
+  }
+  shard.epoch_fingerprint = 14695981039346656037ull;
+}
 
-// The main priority queue of transactions waiting for their turn.
-static std::priority_queue<TrxPriority, std::vector<TrxPriority>, CompareTrxPriority> scheduler_queue;
+// Appends one release decision to the schedule file (shard thread only).
+static void record_release(const SchedulerShard& shard, const SchedRequestNode* node)
+{
+  if (g_record_mode)
+  {
+    g_record_file << shard.epoch_counter << ' ' << node->trx_lib_id << ' '
+      << static_cast<int>(node->intent) << '\n';
+  }
+}
 
 // --- RNG for random priorities ---
-static std::mt19937 rng;
+static int g_rng_seed = 42;
+static std::atomic<uint32_t> g_rng_stream_counter(0);
 
 static void init_rng()
 {
-  int seed = 42;
   const char* seed_str = std::getenv("RANDOM_SEED");
   if (seed_str != nullptr)
   {
     try
     {
-      seed = std::stoi(seed_str);
+      g_rng_seed = std::stoi(seed_str);
     }
     catch (const std::exception&)
     {
     }
   }
-  rng.seed(seed);
 }
 
+// Priorities are drawn from a per-thread generator (seeded from RANDOM_SEED
+// plus a per-thread stream index) so concurrent requesters never share RNG
+// state.
 static int get_random_priority()
 {
+  static thread_local std::mt19937 rng(
+    static_cast<uint32_t>(g_rng_seed) +
+    g_rng_stream_counter.fetch_add(1, std::memory_order_relaxed));
   std::uniform_int_distribution<int> dist(0, 1000000);
   return dist(rng);
 }
 
-// --- Main Scheduler Thread Logic (State Machine) ---
-static void trx_scheduler_run()
+/*
+ * ========================================================================
+ * Priority policies (ISOFUZZ_PRIORITY_POLICY)
+ * ========================================================================
+ * A policy assigns the priority that decides where a request lands in the
+ * epoch's release order. Policies are invoked on the requesting thread and
+ * must be thread-safe. New policies (e.g., POS-style) plug in by
+ * subclassing and extending the selection switch in scheduler_init().
+ */
+class PriorityPolicy
 {
-  while (scheduler_running.load(std::memory_order_acquire))
+public:
+  virtual ~PriorityPolicy() = default;
+  virtual int assign_priority(const SchedRequestNode& node) = 0;
+};
+
+// The classic uniform-random interleaving.
+class RandomPriorityPolicy : public PriorityPolicy
+{
+public:
+  int assign_priority(const SchedRequestNode&) override
+  {
+    return get_random_priority();
+  }
+};
+
+// Biases priorities so that read-write and write-write pairs on the same
+// row land in adjacent slots of the release order, instead of wasting the
+// fuzzing budget on equivalent schedules of non-conflicting operations.
+class ConflictBiasedPriorityPolicy : public PriorityPolicy
+{
+public:
+  int assign_priority(const SchedRequestNode& node) override
+  {
+    int base = get_random_priority();
+    if (!node.has_object)
+    {
+      return base;
+    }
+
+    std::lock_guard lock(m_mtx);
+    auto it = m_recent.find(node.object_key);
+    if (it != m_recent.end())
+    {
+      bool conflicting = node.intent == IsoFuzzSchedulerIntent::OP_WRITE ||
+        it->second.intent == IsoFuzzSchedulerIntent::OP_WRITE;
+      if (conflicting)
+      {
+        // Slot this request directly after the previous toucher of the
+        // same row, forcing the pair to be released back-to-back.
+        int adjacent = ++it->second.priority;
+        it->second.intent = node.intent;
+        return adjacent;
+      }
+    }
+    if (m_recent.size() >= MAX_TRACKED_OBJECTS)
+    {
+      m_recent.clear(); // Cheap wholesale eviction; this is a heuristic.
+    }
+    m_recent[node.object_key] = {base, node.intent};
+    return base;
+  }
+
+private:
+  struct RecentTouch
+  {
+    int priority;
+    IsoFuzzSchedulerIntent intent;
+  };
+
+  static constexpr size_t MAX_TRACKED_OBJECTS = 4096;
+
+  std::mutex m_mtx;
+  std::unordered_map<uint64_t, RecentTouch> m_recent;
+};
+
+static std::unique_ptr<PriorityPolicy> g_priority_policy;
+
+// Pushes a node onto a shard's MPSC inbox. Safe to call from any worker
+// thread. Returns true when the inbox was empty, i.e. this push is the one
+// that should wake the collector.
+static bool inbox_push(SchedulerShard& shard, SchedRequestNode* node)
+{
+  // The observed head must be kept in a local: once the CAS publishes the
+  // node, the shard thread may take the list and rewrite node->next during
+  // reversal, so re-reading the field after publication is a data race.
+  SchedRequestNode* prev = shard.inbox.load(std::memory_order_relaxed);
+  do
+  {
+    node->next = prev;
+  } while (!shard.inbox.compare_exchange_weak(prev, node,
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed));
+  return prev == nullptr;
+}
+
+// Takes a shard's entire inbox in one atomic exchange and reverses it so
+// nodes come back in FIFO (arrival) order. Only the shard thread calls this.
+static SchedRequestNode* inbox_take_all(SchedulerShard& shard)
+{
+  SchedRequestNode* head = shard.inbox.exchange(nullptr, std::memory_order_acquire);
+  SchedRequestNode* reversed = nullptr;
+  while (head != nullptr)
+  {
+    SchedRequestNode* next = head->next;
+    head->next = reversed;
+    reversed = head;
+    head = next;
+  }
+  return reversed;
+}
+
+// Replay loop: releases waiters in exactly the recorded order, blocking
+// until the transaction a schedule entry names has actually arrived.
+// Returns on shutdown or when the recorded schedule is exhausted (the
+// caller then falls back to normal epoch scheduling). Only runs on the
+// single shard that exists in replay mode.
+static void replay_scheduler_run(SchedulerShard& shard)
+{
+  // If the run diverges from the recording (the workload bound lib_ids to
+  // different transactions), the expected transaction may never arrive.
+  // Rather than deadlock the whole DBMS, give up after a stall and fall
+  // back to epoch scheduling for the remaining waiters.
+  const auto stall_limit = std::chrono::seconds(5);
+  auto last_progress = std::chrono::steady_clock::now();
+
+  while (scheduler_running.load(std::memory_order_acquire) &&
+    g_replay_index < g_replay_schedule.size())
   {
-    if (g_epoch_state.load(std::memory_order_relaxed) == EpochState::COLLECTING)
+    // Wait (with a timeout, so shutdown is never missed) for requests.
     {
-      std::this_thread::sleep_for(EPOCH_DURATION_MS);
+      std::unique_lock lock(shard.collector_mutex);
+      shard.collector_cv.wait_for(lock, std::chrono::milliseconds(100), [&shard] {
+        return shard.pending_count.load(std::memory_order_relaxed) > 0 ||
+          !scheduler_running.load(std::memory_order_acquire);
+      });
+    }
+    if (!scheduler_running.load(std::memory_order_acquire))
+    {
+      return;
+    }
 
-      std::queue<TrxPriority> local_pending;
+    SchedRequestNode* node = inbox_take_all(shard);
+    if (node != nullptr)
+    {
+      size_t taken = 0;
+      std::lock_guard lock(shard.global_mutex);
+      while (node != nullptr)
       {
-        std::lock_guard lock(pending_queue_mutex);
-        if (pending_requests.empty())
+        if (!node_cancelled(node))
         {
-          continue;
+          shard.trx_wait_map[node->trx_lib_id] = node;
         }
-        local_pending.swap(pending_requests);
+        ++taken;
+        node = node->next;
       }
+      shard.pending_count.fetch_sub(taken, std::memory_order_relaxed);
+    }
 
+    // Release as many recorded decisions as have arrived, in order. If the
+    // next expected transaction is not here yet, go back to waiting.
+    while (g_replay_index < g_replay_schedule.size())
+    {
+      const ReplayEntry& entry = g_replay_schedule[g_replay_index];
+      SchedRequestNode* to_release = nullptr;
       {
-        std::lock_guard lock(scheduler_global_mutex);
-        while (!local_pending.empty())
+        std::lock_guard lock(shard.global_mutex);
+        auto it = shard.trx_wait_map.find(entry.lib_id);
+        if (it == shard.trx_wait_map.end())
         {
-          scheduler_queue.push(local_pending.front());
-          local_pending.pop();
+          break;
         }
-        g_epoch_state.store(EpochState::DRAINING, std::memory_order_relaxed);
-        scheduler_wakeup_cv.notify_one();
+        to_release = it->second;
+        shard.trx_wait_map.erase(it);
       }
+      shard.epoch_counter = entry.epoch;
+      ++g_replay_index;
+      if (claim_for_release(to_release, entry.lib_id))
+      {
+        release_waiter(&to_release->wait_info);
+        isofuzz_stats::releases.inc();
+      }
+      last_progress = std::chrono::steady_clock::now();
     }
-    else
+
+    if (std::chrono::steady_clock::now() - last_progress > stall_limit)
+    {
+      std::cerr << "IsoFuzz WARNING: replay stalled waiting for trx "
+        << g_replay_schedule[g_replay_index].lib_id << " after "
+        << g_replay_index << " releases; the run has diverged from the "
+        << "recording. Falling back to epoch scheduling." << std::endl;
+      break;
+    }
+  }
+
+  if (scheduler_running.load(std::memory_order_acquire) &&
+    g_replay_index >= g_replay_schedule.size())
+  {
+    std::cerr << "IsoFuzz: recorded schedule exhausted after " << g_replay_index
+      << " releases; falling back to epoch scheduling." << std::endl;
+  }
+
+  // Hand any still-waiting requests over to the normal state machine so
+  // nothing stays blocked forever.
+  std::lock_guard lock(shard.global_mutex);
+  if (!shard.trx_wait_map.empty())
+  {
+    for (const auto& pair : shard.trx_wait_map)
+    {
+      shard.batch.push_back({pair.second->priority, pair.first});
+    }
+    std::sort(shard.batch.begin(), shard.batch.end(),
+              [](const TrxPriority& a, const TrxPriority& b) {
+                return a.first < b.first;
+              });
+    shard.epoch_state.store(EpochState::DRAINING, std::memory_order_relaxed);
+  }
+}
+
+// --- Main Scheduler Thread Logic (State Machine) ---
+static void trx_scheduler_run(SchedulerShard* shard_ptr)
+{
+  SchedulerShard& shard = *shard_ptr;
+  if (g_replay_mode)
+  {
+    replay_scheduler_run(shard);
+  }
+  while (scheduler_running.load(std::memory_order_acquire))
+  {
+    if (shard.epoch_state.load(std::memory_order_relaxed) == EpochState::COLLECTING)
     {
-      // DRAINING state
-      std::unique_lock lock(scheduler_global_mutex);
+      auto collect_start = std::chrono::steady_clock::now();
+      {
+        std::unique_lock lock(shard.collector_mutex);
+        // Sleep until the first request of the epoch arrives; no timed
+        // wakeups while the system is quiet.
+        shard.collector_cv.wait(lock, [&shard] {
+          return shard.pending_count.load(std::memory_order_relaxed) > 0 ||
+            !scheduler_running.load(std::memory_order_acquire);
+        });
+        if (!scheduler_running.load(std::memory_order_acquire))
+        {
+          break;
+        }
+        // Collect until one epoch after the batch's first request arrived —
+        // which may have been during the previous drain, in which case the
+        // window is already partly or fully spent — or stop early once the
+        // batch cap is reached so bursts don't pay the full epoch of
+        // latency.
+        int64_t first_ns = shard.first_arrival_ns.load(std::memory_order_relaxed);
+        auto window_start = (first_ns != 0)
+          ? std::chrono::steady_clock::time_point(std::chrono::nanoseconds(first_ns))
+          : std::chrono::steady_clock::now();
+        auto deadline = window_start + shard.epoch_duration;
+        shard.collector_cv.wait_until(lock, deadline, [&shard] {
+          return (MAX_BATCH != 0 &&
+              shard.pending_count.load(std::memory_order_relaxed) >= MAX_BATCH) ||
+            !scheduler_running.load(std::memory_order_acquire);
+        });
+      }
 
-      if (scheduler_queue.empty())
+      SchedRequestNode* node = inbox_take_all(shard);
+      shard.first_arrival_ns.store(0, std::memory_order_relaxed);
+      if (node == nullptr)
       {
-        g_epoch_state.store(EpochState::COLLECTING, std::memory_order_relaxed);
-        lock.unlock();
         continue;
       }
+      // Build and sort the epoch batch as a flat array before taking the
+      // lock: one O(n log n) pass over contiguous pairs, instead of a heap
+      // sift per element inside the critical section. The cancellation
+      // check happens exactly once per node, here, so the batch and the
+      // wait map stay consistent: a node cancelled after this point still
+      // enters both and is skipped when the drain's release claim fails.
+      std::vector<SchedRequestNode*> live_nodes;
+      std::vector<TrxPriority> sorted_batch;
+      size_t taken = 0;
+      for (SchedRequestNode* n = node; n != nullptr; n = n->next)
+      {
+        ++taken;
+        if (node_cancelled(n))
+        {
+          continue; // Abandoned in the inbox; its waiter is already gone.
+        }
+        live_nodes.push_back(n);
+        sorted_batch.push_back({n->priority, n->trx_lib_id});
+      }
+      std::sort(sorted_batch.begin(), sorted_batch.end(),
+                [](const TrxPriority& a, const TrxPriority& b) {
+                  return a.first < b.first;
+                });
+      size_t batch_size = sorted_batch.size();
+      shard.pending_count.fetch_sub(taken, std::memory_order_relaxed);
+
+      {
+        std::lock_guard lock(shard.global_mutex);
+        for (SchedRequestNode* n : live_nodes)
+        {
+          shard.trx_wait_map[n->trx_lib_id] = n;
+        }
+        shard.batch.swap(sorted_batch);
+        shard.batch_index = 0;
+        ++shard.epoch_counter;
+        shard.epoch_state.store(EpochState::DRAINING, std::memory_order_relaxed);
+        shard.wakeup_cv.notify_one();
+      }
 
-      uint64_t next_trx_id = scheduler_queue.top().second;
-      scheduler_queue.pop();
+      isofuzz_stats::epochs.inc();
+      isofuzz_stats::total_batch.add(batch_size);
+      isofuzz_stats::max_batch.record_max(batch_size);
+      isofuzz_stats::collecting_ns.add(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - collect_start).count()));
+      adapt_epoch_duration(shard, batch_size);
+      maybe_dump_stats(shard);
+    }
+    else
+    {
+      // DRAINING state. One lock acquisition covers the entire epoch's
+      // drain: with waiter registration going through the lock-free inbox
+      // and cancellations resolved by the per-node outcome CAS, the shard
+      // thread is the only steady-state user of global_mutex, so there is
+      // no reason to hand the lock off between release rounds. Holding it
+      // across release_waiter() is safe — released workers only ever
+      // touch the inbox and their own wait_info, never this mutex.
+      auto drain_start = std::chrono::steady_clock::now();
+      std::unique_lock lock(shard.global_mutex);
 
-      auto it = trx_wait_map.find(next_trx_id);
-      if (it != trx_wait_map.end())
+      std::vector<SchedRequestNode*> release_set;
+      while (shard.batch_index < shard.batch.size())
       {
-        // --- CRITICAL CHANGE ---
-        // We retrieve the raw pointer but DO NOT take ownership.
-        TrxWaitInfo* wait_info_ptr = it->second;
+        // Collect the release set: one entry in serial mode (RELEASE_K ==
+        // 1), or up to RELEASE_K entries in priority order as long as they
+        // target pairwise-disjoint objects. An entry with no object
+        // information acts as a barrier: it is only ever released alone,
+        // since we cannot prove it is independent of anything.
+        release_set.clear();
+        int64_t now_ns = steady_now_ns();
+        while (shard.batch_index < shard.batch.size() && release_set.size() < RELEASE_K)
+        {
+          uint64_t next_trx_id = shard.batch[shard.batch_index].second;
+          auto it = shard.trx_wait_map.find(next_trx_id);
+          if (it == shard.trx_wait_map.end())
+          {
+            // The waiter was removed out-of-band — a cancelled (aborted)
+            // transaction whose batch entry is now orphaned. Skip it.
+            ++shard.batch_index;
+            continue;
+          }
+          SchedRequestNode* node = it->second;
+
+          // The watchdog overrides the conflict rules: an entry past the
+          // release timeout joins the round unconditionally rather than
+          // stalling behind a conflict forever.
+          bool timed_out = entry_timed_out(node, now_ns);
+
+          if (!release_set.empty() && !timed_out)
+          {
+            if (!node->has_object)
+            {
+              break; // Unknown object: release it alone in a later round.
+            }
+            bool disjoint = true;
+            for (const SchedRequestNode* taken : release_set)
+            {
+              if (taken->object_key == node->object_key)
+              {
+                disjoint = false;
+                break;
+              }
+            }
+            if (!disjoint)
+            {
+              break; // Conflicting entries stay strictly serialized.
+            }
+          }
 
-        // We are done with this entry in the map, so we erase it.
-        // This prevents other threads from ever seeing a stale pointer.
-        // The worker thread still holds the valid pointer and is responsible for deletion.
-        trx_wait_map.erase(it);
+          ++shard.batch_index;
+          shard.trx_wait_map.erase(it);
 
-        // Release the global lock before notifying the specific thread.
-        lock.unlock();
+          // Claim the node against a racing cancellation; losing means an
+          // abort path already released this waiter, so the entry is just
+          // dropped from the round.
+          if (!claim_for_release(node, next_trx_id))
+          {
+            continue;
+          }
+          if (timed_out)
+          {
+            isofuzz_stats::timeout_releases.inc();
+          }
+          record_release(shard, node);
+          if (g_coverage_mode)
+          {
+            coverage_mix(shard, node);
+          }
+          release_set.push_back(node);
+
+          if (!node->has_object)
+          {
+            break; // Barrier entry: nothing may join its release round.
+          }
+        }
 
-        // Wake up the worker thread.
-        std::unique_lock trx_lock(wait_info_ptr->mtx);
-        wait_info_ptr->is_ready = true;
-        trx_lock.unlock();
-        wait_info_ptr->cv.notify_one();
+        for (SchedRequestNode* node : release_set)
+        {
+          // Wake up the worker thread (plain store if it is still spinning).
+          release_waiter(&node->wait_info);
+        }
+        isofuzz_stats::releases.add(release_set.size());
+        if (release_set.size() > 1)
+        {
+          isofuzz_stats::batched_releases.add(release_set.size());
+        }
       }
-      else
+
+      if (g_coverage_mode && !shard.batch.empty())
       {
-        // This should not happen if the logic is correct.
-        // It means a request was scheduled for which we have no waiter info.
-        assert(false && "Scheduler found a transaction ID with no waiter info.");
-        lock.unlock();
+        coverage_flush_epoch(shard);
       }
+      shard.batch.clear();
+      shard.batch_index = 0;
+      shard.epoch_state.store(EpochState::COLLECTING, std::memory_order_relaxed);
+      lock.unlock();
+      isofuzz_stats::draining_ns.add(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - drain_start).count()));
     }
   }
 }
@@ -186,8 +980,242 @@ void scheduler_init()
       {
       }
     }
+    const char* max_batch_str = std::getenv("ISOFUZZ_MAX_BATCH");
+    if (max_batch_str)
+    {
+      try
+      {
+        long batch = std::stol(max_batch_str);
+        if (batch > 0)
+        {
+          MAX_BATCH = static_cast<size_t>(batch);
+        }
+      }
+      catch (const std::exception&)
+      {
+      }
+    }
+    const char* stats_period_str = std::getenv("ISOFUZZ_STATS_PERIOD_EPOCHS");
+    if (stats_period_str)
+    {
+      try
+      {
+        long period = std::stol(stats_period_str);
+        if (period > 0)
+        {
+          STATS_PERIOD_EPOCHS = static_cast<uint64_t>(period);
+        }
+      }
+      catch (const std::exception&)
+      {
+      }
+    }
+    const char* target_batch_str = std::getenv("ISOFUZZ_TARGET_BATCH");
+    if (target_batch_str)
+    {
+      try
+      {
+        long target = std::stol(target_batch_str);
+        if (target > 0)
+        {
+          TARGET_BATCH = static_cast<size_t>(target);
+        }
+      }
+      catch (const std::exception&)
+      {
+      }
+    }
+    const char* epoch_min_str = std::getenv("ISOFUZZ_EPOCH_MIN_MS");
+    if (epoch_min_str)
+    {
+      try
+      {
+        long ms = std::stol(epoch_min_str);
+        if (ms > 0)
+        {
+          EPOCH_MIN = std::chrono::milliseconds(ms);
+        }
+      }
+      catch (const std::exception&)
+      {
+      }
+    }
+    const char* epoch_max_str = std::getenv("ISOFUZZ_EPOCH_MAX_MS");
+    if (epoch_max_str)
+    {
+      try
+      {
+        long ms = std::stol(epoch_max_str);
+        if (ms > 0)
+        {
+          EPOCH_MAX = std::chrono::milliseconds(ms);
+        }
+      }
+      catch (const std::exception&)
+      {
+      }
+    }
+    if (EPOCH_MAX < EPOCH_MIN)
+    {
+      std::cerr << "IsoFuzz WARNING: ISOFUZZ_EPOCH_MAX_MS is below "
+        << "ISOFUZZ_EPOCH_MIN_MS; using the minimum for both." << std::endl;
+      EPOCH_MAX = EPOCH_MIN;
+    }
+    const char* release_k_str = std::getenv("ISOFUZZ_RELEASE_K");
+    if (release_k_str)
+    {
+      try
+      {
+        long k = std::stol(release_k_str);
+        if (k >= 1)
+        {
+          RELEASE_K = static_cast<size_t>(k);
+        }
+      }
+      catch (const std::exception&)
+      {
+      }
+    }
+    const char* timeout_str = std::getenv("ISOFUZZ_RELEASE_TIMEOUT_MS");
+    if (timeout_str)
+    {
+      try
+      {
+        long ms = std::stol(timeout_str);
+        if (ms > 0)
+        {
+          RELEASE_TIMEOUT_MS = std::chrono::milliseconds(ms);
+        }
+      }
+      catch (const std::exception&)
+      {
+      }
+    }
+    const char* spin_str = std::getenv("ISOFUZZ_SPIN_CYCLES");
+    if (spin_str)
+    {
+      try
+      {
+        long cycles = std::stol(spin_str);
+        if (cycles >= 0)
+        {
+          SPIN_CYCLES = cycles;
+        }
+      }
+      catch (const std::exception&)
+      {
+      }
+    }
+    const char* shards_str = std::getenv("ISOFUZZ_SCHED_SHARDS");
+    if (shards_str)
+    {
+      try
+      {
+        long n = std::stol(shards_str);
+        if (n >= 1 && n <= 64)
+        {
+          NUM_SCHED_SHARDS = static_cast<size_t>(n);
+        }
+      }
+      catch (const std::exception&)
+      {
+      }
+    }
+    const char* cpus_str = std::getenv("ISOFUZZ_SCHED_CPUS");
+    if (cpus_str)
+    {
+      std::stringstream cpus_ss(cpus_str);
+      std::string token;
+      while (std::getline(cpus_ss, token, ','))
+      {
+        try
+        {
+          int cpu = std::stoi(token);
+          if (cpu >= 0)
+          {
+            g_sched_cpus.push_back(cpu);
+          }
+        }
+        catch (const std::exception&)
+        {
+        }
+      }
+    }
+    const char* replay_path = std::getenv("ISOFUZZ_SCHEDULE_REPLAY");
+    if (replay_path)
+    {
+      std::ifstream replay_file(replay_path);
+      ReplayEntry entry;
+      while (replay_file >> entry.epoch >> entry.lib_id >> entry.intent)
+      {
+        g_replay_schedule.push_back(entry);
+      }
+      g_replay_mode = !g_replay_schedule.empty();
+      if (!g_replay_mode)
+      {
+        std::cerr << "IsoFuzz WARNING: Could not read schedule from "
+          << replay_path << "; using epoch scheduling." << std::endl;
+      }
+    }
+    const char* coverage_path = std::getenv("ISOFUZZ_COVERAGE_FILE");
+    if (coverage_path)
+    {
+      g_coverage_file.open(coverage_path, std::ios::out | std::ios::trunc);
+      g_coverage_mode = g_coverage_file.is_open();
+      if (!g_coverage_mode)
+      {
+        std::cerr << "IsoFuzz WARNING: Could not open coverage file "
+          << coverage_path << "." << std::endl;
+      }
+    }
+    const char* record_path = std::getenv("ISOFUZZ_SCHEDULE_RECORD");
+    if (record_path && !g_replay_mode)
+    {
+      g_record_file.open(record_path, std::ios::out | std::ios::trunc);
+      g_record_mode = g_record_file.is_open();
+      if (!g_record_mode)
+      {
+        std::cerr << "IsoFuzz WARNING: Could not open schedule record file "
+          << record_path << "." << std::endl;
+      }
+    }
+    // A recorded schedule is one total order over all releases; it cannot
+    // be recorded from or replayed onto several independent shards.
+    if ((g_record_mode || g_replay_mode) && NUM_SCHED_SHARDS > 1)
+    {
+      std::cerr << "IsoFuzz WARNING: schedule record/replay requires a single "
+        << "scheduler; ignoring ISOFUZZ_SCHED_SHARDS=" << NUM_SCHED_SHARDS
+        << "." << std::endl;
+      NUM_SCHED_SHARDS = 1;
+    }
     init_rng();
-    scheduler_thread = std::thread(trx_scheduler_run);
+    const char* policy_str = std::getenv("ISOFUZZ_PRIORITY_POLICY");
+    if (policy_str != nullptr && std::string(policy_str) == "conflict")
+    {
+      g_priority_policy = std::make_unique<ConflictBiasedPriorityPolicy>();
+    }
+    else
+    {
+      g_priority_policy = std::make_unique<RandomPriorityPolicy>();
+    }
+    g_shards.clear();
+    g_shards.reserve(NUM_SCHED_SHARDS);
+    for (size_t i = 0; i < NUM_SCHED_SHARDS; ++i)
+    {
+      auto shard = std::make_unique<SchedulerShard>();
+      shard->index = i;
+      // Each shard starts from the configured fixed window; the adaptive
+      // controller then moves it independently within [EPOCH_MIN, EPOCH_MAX].
+      shard->epoch_duration = TARGET_BATCH == 0
+        ? std::chrono::nanoseconds(EPOCH_DURATION_MS)
+        : std::clamp(std::chrono::nanoseconds(EPOCH_DURATION_MS), EPOCH_MIN, EPOCH_MAX);
+      g_shards.push_back(std::move(shard));
+    }
+    for (auto& shard : g_shards)
+    {
+      shard->thread = std::thread(trx_scheduler_run, shard.get());
+      pin_shard_thread(*shard);
+    }
   }
 }
 
@@ -195,56 +1223,208 @@ void scheduler_shutdown()
 {
   if (scheduler_running.exchange(false, std::memory_order_acq_rel))
   {
-    scheduler_wakeup_cv.notify_one();
-    if (scheduler_thread.joinable())
+    for (auto& shard : g_shards)
     {
-      scheduler_thread.join();
+      {
+        std::lock_guard lock(shard->collector_mutex);
+      }
+      shard->collector_cv.notify_one();
+      shard->wakeup_cv.notify_one();
+    }
+    for (auto& shard : g_shards)
+    {
+      if (shard->thread.joinable())
+      {
+        shard->thread.join();
+      }
     }
-    // Clean up any remaining waiters to prevent deadlocks on shutdown.
-    std::lock_guard lock(scheduler_global_mutex);
-    for (auto& pair : trx_wait_map)
+    if (g_record_mode)
     {
-      pair.second->is_ready = true;
-      pair.second->cv.notify_all();
+      g_record_file.flush();
+      g_record_file.close();
+      g_record_mode = false;
+    }
+    if (g_coverage_mode)
+    {
+      std::lock_guard cov_lock(g_coverage_mutex);
+      g_coverage_file.flush();
+      g_coverage_file.close();
+      g_coverage_mode = false;
+    }
+    // Clean up any remaining waiters to prevent deadlocks on shutdown. This
+    // covers both waiters already registered in the map and requests still
+    // sitting in the inbox that the shard thread never got to consume.
+    for (auto& shard : g_shards)
+    {
+      std::lock_guard lock(shard->global_mutex);
+      SchedRequestNode* node = inbox_take_all(*shard);
+      while (node != nullptr)
+      {
+        if (!node_cancelled(node))
+        {
+          shard->trx_wait_map[node->trx_lib_id] = node;
+        }
+        node = node->next;
+      }
+      for (auto& pair : shard->trx_wait_map)
+      {
+        if (claim_for_release(pair.second, pair.first))
+        {
+          release_waiter(&pair.second->wait_info);
+        }
+      }
+      shard->trx_wait_map.clear();
+
+      // --- INVARIANT CHECK ON SHUTDOWN ---
+      // On a clean shutdown, the wait map should be empty. If it's not,
+      // it implies some transactions were blocked and never cleaned up,
+      // which would lead to a memory leak.
+      assert(shard->trx_wait_map.empty() && "trx_wait_map not empty on shutdown; memory will be leaked.");
     }
-    trx_wait_map.clear();
+  }
+}
 
-    // --- INVARIANT CHECK ON SHUTDOWN ---
-    // On a clean shutdown, the wait map should be empty. If it's not,
-    // it implies some transactions were blocked and never cleaned up,
-    // which would lead to a memory leak.
-    assert(trx_wait_map.empty() && "trx_wait_map not empty on shutdown; memory will be leaked.");
+// FNV-1a over a table name. Used both as the shard-routing key and as the
+// first half of the object identity key, so all operations on one table
+// always land on the same shard.
+static uint64_t table_name_hash(const char* table_name)
+{
+  uint64_t h = 14695981039346656037ull;
+  for (const char* p = table_name; p != nullptr && *p != '\0'; ++p)
+  {
+    h ^= static_cast<unsigned char>(*p);
+    h *= 1099511628211ull;
   }
+  return h;
 }
 
-// This function now just adds requests to the pending queue.
-void scheduler_request(uint64_t trx_lib_id, IsoFuzzSchedulerIntent /* intent */) {
-  // Step 1: The worker thread allocates its own waiter object on the heap.
-  TrxWaitInfo* wait_info_ptr = new TrxWaitInfo();
+// Hashes the identity of a data object, (table_name, row_identifier), into
+// a single key. Computed at request time because the strings in the
+// IsoFuzzObject are only guaranteed to live for the duration of the call.
+static uint64_t object_identity_key(const IsoFuzzObject* object)
+{
+  uint64_t h = table_name_hash(object->table_name);
+  h ^= object->row_identifier + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+  return h;
+}
 
-  TrxPriority priority_entry = {get_random_priority(), trx_lib_id};
+// Picks the shard responsible for a request. Operations on the same table
+// always route to the same shard; requests with no object information (and
+// everything, when there is only one shard) go to shard 0.
+static SchedulerShard& shard_for_request(const IsoFuzzObject* object)
+{
+  if (NUM_SCHED_SHARDS == 1 || object == nullptr)
+  {
+    return *g_shards[0];
+  }
+  return *g_shards[table_name_hash(object->table_name) % NUM_SCHED_SHARDS];
+}
 
-  // Step 2: Add the request to the pending queue for the scheduler thread.
+void scheduler_cancel_pending(uint64_t trx_lib_id,
+                              std::atomic<SchedRequestNode*>& pending_slot)
+{
+  if (!scheduler_running.load(std::memory_order_acquire))
+  {
+    return;
+  }
+  // The pending request is reached directly through the transaction's
+  // slot — no shard iteration, no locks, and crucially no blindness to
+  // requests that are still in an inbox (where a request spends the whole
+  // collection window). The id-tagged outcome CAS arbitrates against the
+  // scheduler's release paths and defeats a stale pointer: if the node
+  // was already released (and possibly reused for another transaction),
+  // the expected value is gone and this is a no-op.
+  SchedRequestNode* node = pending_slot.load(std::memory_order_acquire);
+  if (node == nullptr)
+  {
+    return; // Nothing pending.
+  }
+  uint64_t expected = outcome_word(trx_lib_id, OUTCOME_PENDING);
+  if (!node->outcome.compare_exchange_strong(
+        expected, outcome_word(trx_lib_id, OUTCOME_CANCELLED),
+        std::memory_order_acq_rel, std::memory_order_acquire))
   {
-    std::lock_guard lock(pending_queue_mutex);
-    pending_requests.push(priority_entry);
+    return; // The release (or another canceller) won the race.
   }
+  isofuzz_stats::cancellations.inc();
+  release_waiter(&node->wait_info);
+  // The node's inbox/batch/map entries are now orphans; every scheduler
+  // path skips them via the outcome check, and the owning thread abandons
+  // the node rather than reusing it (see scheduler_request()).
+}
 
-  // Step 3: Add the NON-OWNING pointer to the global map so the scheduler can find it.
+// This function enqueues the request with a single lock-free push.
+void scheduler_request(uint64_t trx_lib_id, IsoFuzzSchedulerIntent intent,
+                       const IsoFuzzObject* object,
+                       std::atomic<SchedRequestNode*>* pending_slot) {
+  // Step 1: Reset this thread's reusable request node. No allocation takes
+  // place on this path after the thread's first request; the node and its
+  // embedded waiter are reused for every subsequent one.
+  isofuzz_stats::requests.inc();
+  if (t_request_node == nullptr)
+  {
+    t_request_node = new SchedRequestNode;
+  }
+  SchedRequestNode* node = t_request_node;
+  node->trx_lib_id = trx_lib_id;
+  node->intent = intent;
+  node->has_object = (object != nullptr);
+  node->object_key = (object != nullptr) ? object_identity_key(object) : 0;
+  node->priority = g_priority_policy
+                     ? g_priority_policy->assign_priority(*node)
+                     : get_random_priority();
+  node->enqueue_ns = steady_now_ns();
+  node->wait_info.is_ready.store(false, std::memory_order_relaxed);
+  node->wait_info.parked.store(false, std::memory_order_relaxed);
+  node->outcome.store(outcome_word(trx_lib_id, OUTCOME_PENDING),
+                      std::memory_order_release);
+  if (pending_slot != nullptr)
   {
-    std::lock_guard lock(scheduler_global_mutex);
-    trx_wait_map[trx_lib_id] = wait_info_ptr;
+    // Publish the node for cancellation before it becomes reachable via
+    // the inbox, so an abort path can always find a blocked request.
+    pending_slot->store(node, std::memory_order_release);
   }
 
-  // Step 4: The worker thread blocks, waiting for the scheduler to signal its CV.
+  // Step 2: Hand the priority entry and the waiter to the owning shard in
+  // one node. The shard thread performs the trx_wait_map insertion when it
+  // drains the inbox. The collector is only woken on the empty->non-empty
+  // transition or when this request fills the batch, so the steady-state
+  // path takes no mutex.
+  SchedulerShard& shard = shard_for_request(object);
+  bool was_empty = inbox_push(shard, node);
+  if (was_empty)
+  {
+    // This request opens the next epoch's collection window. Recorded even
+    // while the shard is still draining, so the window overlaps the drain.
+    shard.first_arrival_ns.store(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count(),
+      std::memory_order_relaxed);
+  }
+  size_t count = shard.pending_count.fetch_add(1, std::memory_order_relaxed) + 1;
+  if (was_empty || (MAX_BATCH != 0 && count == MAX_BATCH))
   {
-    std::unique_lock trx_lock(wait_info_ptr->mtx);
-    wait_info_ptr->cv.wait(trx_lock, [wait_info_ptr] { return wait_info_ptr->is_ready; });
+    { std::lock_guard lock(shard.collector_mutex); }
+    shard.collector_cv.notify_one();
   }
 
-  // Step 5: CRITICAL CLEANUP
-  // Once woken up, the worker thread is now responsible for deleting the
-  // waiter object it created. This happens on the same thread that called `new`,
-  // eliminating the cross-thread destruction and the heap corruption bug.
-  delete wait_info_ptr;
+  // Step 3: Spin briefly on is_ready, then park on the CV if the release
+  // has not arrived.
+  await_release(&node->wait_info);
+
+  bool cancelled = node->outcome.load(std::memory_order_acquire) ==
+    outcome_word(trx_lib_id, OUTCOME_CANCELLED);
+  if (pending_slot != nullptr)
+  {
+    pending_slot->store(nullptr, std::memory_order_release);
+  }
+  if (cancelled)
+  {
+    // A cancellation released us while the node's inbox or batch entry is
+    // still queued somewhere. The node cannot be reused until the
+    // scheduler has passed that orphan, so abandon it (the next request
+    // allocates a fresh one) and let it leak — cancellations are rare
+    // abort-path events, and the orphan's fields must stay readable.
+    t_request_node = nullptr;
+  }
 }
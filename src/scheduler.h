@@ -4,10 +4,30 @@
 #include "isofuzz_ctx.h"
 #include "../include/isofuzz.h"
 
+#include <atomic>
+
+struct SchedRequestNode;
+
 void scheduler_init();
 void scheduler_shutdown();
 
-// The scheduler now takes the library-internal transaction ID and the intent.
-void scheduler_request(uint64_t trx_lib_id, IsoFuzzSchedulerIntent intent);
+// The scheduler takes the library-internal transaction ID, the intent, and
+// optionally the object the operation targets. Passing the object lets the
+// scheduler reason about conflicts (e.g., release disjoint operations
+// concurrently); a null object is always treated conservatively. While the
+// call blocks, the node it is waiting on is published through pending_slot
+// (the transaction's pending_request member) so scheduler_cancel_pending()
+// can reach it; a null slot makes the request uncancellable.
+void scheduler_request(uint64_t trx_lib_id, IsoFuzzSchedulerIntent intent,
+                       const IsoFuzzObject* object = nullptr,
+                       std::atomic<SchedRequestNode*>* pending_slot = nullptr);
+
+// Cancels the transaction's pending request published in pending_slot (if
+// any) and releases its waiter immediately, whether the request is still
+// in a shard's inbox or already registered for release — the scheduler
+// skips the cancelled entry when it reaches it. Safe to call from any
+// thread; a no-op when nothing is pending or the release already won.
+void scheduler_cancel_pending(uint64_t trx_lib_id,
+                              std::atomic<SchedRequestNode*>& pending_slot);
 
 #endif // SCHEDULER_H
@@ -0,0 +1,53 @@
+#ifndef ISOFUZZ_STATS_H
+#define ISOFUZZ_STATS_H
+
+#include <atomic>
+#include <cstdint>
+
+/*
+ * ========================================================================
+ * Hot-path counters
+ * ========================================================================
+ * Lightweight instrumentation shared between the scheduler, logger, and
+ * the public isofuzz_get_stats() surface. Every counter is a relaxed
+ * atomic on its own cache line, so updating one from a hot path costs a
+ * single uncontended RMW and never perturbs the code being measured.
+ */
+
+struct alignas(64) IsoFuzzCounter
+{
+  std::atomic<uint64_t> v{0};
+
+  void add(uint64_t n) { v.fetch_add(n, std::memory_order_relaxed); }
+  void inc() { add(1); }
+
+  // Monotonic max, e.g. for the largest batch seen.
+  void record_max(uint64_t n)
+  {
+    uint64_t cur = v.load(std::memory_order_relaxed);
+    while (n > cur && !v.compare_exchange_weak(cur, n, std::memory_order_relaxed))
+    {
+    }
+  }
+
+  uint64_t get() const { return v.load(std::memory_order_relaxed); }
+};
+
+namespace isofuzz_stats
+{
+inline IsoFuzzCounter requests;         // Scheduling requests submitted.
+inline IsoFuzzCounter releases;         // Waiters released.
+inline IsoFuzzCounter batched_releases; // Releases that shared a round with others.
+inline IsoFuzzCounter spin_wakeups;     // Waits satisfied while still spinning.
+inline IsoFuzzCounter parked_wakeups;   // Waits that had to park on the cv.
+inline IsoFuzzCounter epochs;           // Completed collect->drain cycles.
+inline IsoFuzzCounter total_batch;      // Sum of epoch batch sizes.
+inline IsoFuzzCounter max_batch;        // Largest epoch batch seen.
+inline IsoFuzzCounter collecting_ns;    // Scheduler time spent collecting.
+inline IsoFuzzCounter draining_ns;      // Scheduler time spent draining.
+inline IsoFuzzCounter events_logged;    // Trace events produced.
+inline IsoFuzzCounter cancellations;    // Pending requests cancelled by abort paths.
+inline IsoFuzzCounter timeout_releases; // Entries force-released by the watchdog.
+} // namespace isofuzz_stats
+
+#endif // ISOFUZZ_STATS_H
@@ -0,0 +1,70 @@
+#ifndef ISOFUZZ_TRACE_FORMAT_H
+#define ISOFUZZ_TRACE_FORMAT_H
+
+#include <cstdint>
+
+/*
+ * ========================================================================
+ * Binary trace format (ISOFUZZ_BINARY_TRACE=1)
+ * ========================================================================
+ * A compact, fixed-width alternative to the tab-separated text trace.
+ * The stream is a sequence of records, each starting with a one-byte type
+ * tag. Table and column names are interned: the first time a name is seen
+ * a NAME record mapping id -> string is emitted, and all EVENT records
+ * refer to names by id only. All integers are little-endian (the format is
+ * written with plain memcpy of the packed structs below; traces are decoded
+ * on the same architecture family that produced them).
+ *
+ * The stream begins with a 5-byte header: the magic "IFZB" followed by a
+ * one-byte format version. Because OUT_FILE is opened in append mode, a
+ * header may also appear mid-stream when several runs share one file;
+ * decoders must accept a header at any record boundary.
+ *
+ * The reference decoder is scripts/decode_trace.py, which reconstructs the
+ * exact text lines the TSV mode would have produced.
+ */
+
+constexpr char ISOFUZZ_TRACE_MAGIC[4] = {'I', 'F', 'Z', 'B'};
+constexpr uint8_t ISOFUZZ_TRACE_VERSION = 2;
+
+// Record type tags.
+constexpr uint8_t ISOFUZZ_REC_EVENT = 1;
+constexpr uint8_t ISOFUZZ_REC_NAME = 2;
+
+#pragma pack(push, 1)
+
+// One logged operation. Fixed width so writers can emit it with a single
+// memcpy and decoders can read it with a single struct unpack.
+struct IsoFuzzBinEvent
+{
+  uint8_t record_type; // ISOFUZZ_REC_EVENT
+  uint8_t op_type;     // Numeric value of IsoFuzzOpType
+  uint8_t has_object;  // 0 for BEGIN/COMMIT/PROMOTE-style events
+  uint8_t reserved;
+  // Global sequence number stamped at event creation. Emission order in
+  // the file is NOT the event order (per-thread buffers and the async
+  // writer reorder freely); consumers must sort by seq.
+  uint64_t seq;
+  uint32_t table_id;  // Interned name id, 0 = none
+  uint32_t column_id; // Interned name id, 0 = none
+  uint64_t thread_id; // Hash of the originating std::thread::id
+  uint64_t trx_id;
+  uint64_t row_identifier;
+  uint64_t last_writer_trx_id;
+};
+
+// Prefix of a NAME record; immediately followed by `length` bytes of the
+// (non-NUL-terminated) name string.
+struct IsoFuzzBinName
+{
+  uint8_t record_type; // ISOFUZZ_REC_NAME
+  uint32_t id;
+  uint16_t length;
+};
+
+#pragma pack(pop)
+
+static_assert(sizeof(IsoFuzzBinEvent) == 52, "Binary event record layout changed; bump ISOFUZZ_TRACE_VERSION.");
+static_assert(sizeof(IsoFuzzBinName) == 7, "Binary name record layout changed; bump ISOFUZZ_TRACE_VERSION.");
+
+#endif // ISOFUZZ_TRACE_FORMAT_H
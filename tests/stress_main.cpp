@@ -0,0 +1,412 @@
+// Stress and soak harness for libisofuzz.
+//
+// Simulates a thread-per-connection DBMS: N worker threads run randomized
+// transaction mixes over a synthetic keyspace through the full public API
+// (begin, schedule, log, commit/abort, end), then the harness checks the
+// invariants every concurrency change in the scheduler must preserve:
+//
+//   - no lost wakeups: every worker finishes within a grace period after
+//     the stop flag is raised (a thread stuck in isofuzz_schedule_op means
+//     a release was dropped);
+//   - no leaked waiters: scheduling requests == releases + cancellations
+//     once all workers have returned;
+//   - monotonic sequence numbers: the trace's seq column is exactly the
+//     set 1..events_logged with no gaps or duplicates (with
+//     ISOFUZZ_TRX_BUFFER=1 dropping aborted transactions' events, gaps
+//     are expected and only range/duplicate violations count).
+//
+// Build with -DISOFUZZ_BUILD_TESTS=ON; registered with CTest as a short
+// smoke run. The scheduler/logger are configured through the usual
+// environment variables, so the same binary soaks any configuration
+// (shards, release-K, timeouts, trace modes, ...). Unless OUT_FILE is
+// already set, the harness writes the trace to a temporary file so it can
+// verify the sequence invariant; with a user-set OUT_FILE or a binary
+// trace that check is skipped.
+//
+// Usage:
+//   isofuzz_stress [--threads N] [--seconds S] [--ops-per-trx K]
+//                  [--tables T] [--rows R] [--mix READ:UPD:INS:DEL]
+//                  [--abort-pct P]
+
+#include "isofuzz.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+namespace
+{
+
+struct StressConfig
+{
+  int threads = 8;
+  int seconds = 5;
+  int ops_per_trx = 4;
+  int tables = 4;
+  uint64_t rows = 1024;
+  // Op mix weights in the order read:update:insert:delete.
+  int mix[4] = {70, 20, 5, 5};
+  int abort_pct = 5;
+};
+
+struct WorkerResult
+{
+  std::vector<uint64_t> trx_latencies_ns; // One sample per transaction.
+  uint64_t ops = 0;
+  uint64_t aborts = 0;
+};
+
+using Clock = std::chrono::steady_clock;
+
+std::atomic<bool> g_stop(false);
+std::atomic<int> g_finished_workers(0);
+
+// Grace period after g_stop before a still-running worker is declared
+// stuck. Generous: a worker finishes its in-flight transaction first, and
+// the slowest legitimate wait is one full epoch plus drain.
+constexpr int JOIN_GRACE_SECONDS = 30;
+
+// The synthetic keyspace: a handful of tables whose names are stable
+// across the run so contention concentrates the way a real workload's
+// does. Kept small enough that the conflict-aware policies have work to
+// do.
+const char* table_name(int table)
+{
+  static const char* NAMES[] = {
+    "stress_t0", "stress_t1", "stress_t2", "stress_t3",
+    "stress_t4", "stress_t5", "stress_t6", "stress_t7"
+  };
+  return NAMES[table % 8];
+}
+
+void worker_run(const StressConfig& cfg, int worker_id, WorkerResult& result)
+{
+  // Deterministic per-worker stream: the same seed and thread count replay
+  // the same op sequence (scheduling decisions still vary).
+  std::mt19937_64 rng(0x5eed0000u + static_cast<uint64_t>(worker_id));
+  std::uniform_int_distribution<uint64_t> row_dist(0, cfg.rows - 1);
+  std::uniform_int_distribution<int> table_dist(0, cfg.tables - 1);
+  std::uniform_int_distribution<int> pct_dist(0, 99);
+  const int mix_total = cfg.mix[0] + cfg.mix[1] + cfg.mix[2] + cfg.mix[3];
+  std::uniform_int_distribution<int> mix_dist(0, mix_total - 1);
+
+  result.trx_latencies_ns.reserve(1u << 16);
+
+  while (!g_stop.load(std::memory_order_relaxed))
+  {
+    auto start = Clock::now();
+    isofuzz_trx_t trx = isofuzz_trx_begin();
+
+    for (int i = 0; i < cfg.ops_per_trx; ++i)
+    {
+      IsoFuzzObject obj{table_name(table_dist(rng)), "v", row_dist(rng)};
+      int pick = mix_dist(rng);
+      if (pick < cfg.mix[0])
+      {
+        isofuzz_schedule_data_op(trx, IsoFuzzSchedulerIntent::OP_READ, obj);
+        isofuzz_log_op(trx, IsoFuzzOpType::READ, obj, 0);
+      }
+      else if (pick < cfg.mix[0] + cfg.mix[1])
+      {
+        isofuzz_schedule_data_op(trx, IsoFuzzSchedulerIntent::OP_WRITE, obj);
+        isofuzz_log_op(trx, IsoFuzzOpType::WRITE_UPDATE, obj, 0);
+      }
+      else if (pick < cfg.mix[0] + cfg.mix[1] + cfg.mix[2])
+      {
+        isofuzz_schedule_data_op(trx, IsoFuzzSchedulerIntent::OP_WRITE, obj);
+        isofuzz_log_op(trx, IsoFuzzOpType::WRITE_INSERT, obj, 0);
+      }
+      else
+      {
+        isofuzz_schedule_data_op(trx, IsoFuzzSchedulerIntent::OP_WRITE, obj);
+        isofuzz_log_op(trx, IsoFuzzOpType::WRITE_DELETE, obj, 0);
+      }
+      ++result.ops;
+    }
+
+    if (pct_dist(rng) < cfg.abort_pct)
+    {
+      // Abort path: no COMMIT event, straight to cleanup, like a DBMS
+      // rolling back after a conflict.
+      ++result.aborts;
+    }
+    else
+    {
+      isofuzz_trx_commit(trx);
+    }
+    isofuzz_trx_end(trx);
+
+    auto end = Clock::now();
+    result.trx_latencies_ns.push_back(
+      static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+  }
+
+  g_finished_workers.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t percentile(std::vector<uint64_t>& sorted, double p)
+{
+  if (sorted.empty()) return 0;
+  size_t idx = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1));
+  return sorted[idx];
+}
+
+// Reads the text trace back and verifies the seq column is exactly the
+// set 1..expected with no gaps or duplicates. Returns false on violation.
+// With expect_complete false (trx buffering in its default drop-aborts
+// mode legitimately removes aborted transactions' events while the
+// counter still counts them), only the range and duplicate checks apply.
+bool check_sequence_numbers(const std::string& trace_path, uint64_t expected,
+                            bool expect_complete)
+{
+  std::ifstream in(trace_path);
+  if (!in.is_open())
+  {
+    std::fprintf(stderr, "INVARIANT seq: could not reopen trace %s\n", trace_path.c_str());
+    return false;
+  }
+
+  std::vector<bool> seen(static_cast<size_t>(expected) + 1, false);
+  uint64_t count = 0;
+  bool ok = true;
+  std::string line;
+  while (std::getline(in, line))
+  {
+    if (line.empty()) continue;
+    uint64_t seq = std::strtoull(line.c_str(), nullptr, 10);
+    if (seq == 0 || seq > expected)
+    {
+      std::fprintf(stderr, "INVARIANT seq: out-of-range seq %llu (expected 1..%llu)\n",
+                   static_cast<unsigned long long>(seq),
+                   static_cast<unsigned long long>(expected));
+      ok = false;
+      continue;
+    }
+    if (seen[static_cast<size_t>(seq)])
+    {
+      std::fprintf(stderr, "INVARIANT seq: duplicate seq %llu\n",
+                   static_cast<unsigned long long>(seq));
+      ok = false;
+      continue;
+    }
+    seen[static_cast<size_t>(seq)] = true;
+    ++count;
+  }
+
+  if (expect_complete && count != expected)
+  {
+    std::fprintf(stderr, "INVARIANT seq: trace has %llu events, counters say %llu\n",
+                 static_cast<unsigned long long>(count),
+                 static_cast<unsigned long long>(expected));
+    ok = false;
+  }
+  return ok;
+}
+
+bool parse_mix(const char* arg, StressConfig& cfg)
+{
+  int parsed = std::sscanf(arg, "%d:%d:%d:%d",
+                           &cfg.mix[0], &cfg.mix[1], &cfg.mix[2], &cfg.mix[3]);
+  if (parsed != 4) return false;
+  for (int weight : cfg.mix)
+  {
+    if (weight < 0) return false;
+  }
+  return cfg.mix[0] + cfg.mix[1] + cfg.mix[2] + cfg.mix[3] > 0;
+}
+
+bool parse_args(int argc, char** argv, StressConfig& cfg)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    auto next_value = [&](long& out) {
+      if (i + 1 >= argc) return false;
+      out = std::stol(argv[++i]);
+      return true;
+    };
+    long value = 0;
+    if (std::strcmp(argv[i], "--threads") == 0 && next_value(value))
+    {
+      cfg.threads = static_cast<int>(value);
+    }
+    else if (std::strcmp(argv[i], "--seconds") == 0 && next_value(value))
+    {
+      cfg.seconds = static_cast<int>(value);
+    }
+    else if (std::strcmp(argv[i], "--ops-per-trx") == 0 && next_value(value))
+    {
+      cfg.ops_per_trx = static_cast<int>(value);
+    }
+    else if (std::strcmp(argv[i], "--tables") == 0 && next_value(value))
+    {
+      cfg.tables = static_cast<int>(value);
+    }
+    else if (std::strcmp(argv[i], "--rows") == 0 && next_value(value))
+    {
+      cfg.rows = static_cast<uint64_t>(value);
+    }
+    else if (std::strcmp(argv[i], "--abort-pct") == 0 && next_value(value))
+    {
+      cfg.abort_pct = static_cast<int>(value);
+    }
+    else if (std::strcmp(argv[i], "--mix") == 0 && i + 1 < argc)
+    {
+      if (!parse_mix(argv[++i], cfg))
+      {
+        std::fprintf(stderr, "Bad --mix (expected READ:UPD:INS:DEL weights)\n");
+        return false;
+      }
+    }
+    else
+    {
+      std::fprintf(stderr, "Unknown or incomplete argument: %s\n", argv[i]);
+      return false;
+    }
+  }
+  return cfg.threads > 0 && cfg.seconds > 0 && cfg.ops_per_trx > 0 &&
+    cfg.tables > 0 && cfg.tables <= 8 && cfg.rows > 0 &&
+    cfg.abort_pct >= 0 && cfg.abort_pct <= 100;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  StressConfig cfg;
+  if (!parse_args(argc, argv, cfg))
+  {
+    return 1;
+  }
+
+  // Own the trace destination when the caller didn't, so the sequence
+  // invariant can be checked afterwards. A user-set OUT_FILE (or binary
+  // trace) is respected; the seq check is then skipped.
+  bool check_seq = false;
+  std::string trace_path;
+  const char* binary_env = std::getenv("ISOFUZZ_BINARY_TRACE");
+  bool binary_trace = (binary_env != nullptr && std::strcmp(binary_env, "1") == 0);
+  if (std::getenv("OUT_FILE") == nullptr && !binary_trace)
+  {
+    trace_path = "isofuzz_stress_trace." + std::to_string(::getpid()) + ".log";
+    setenv("OUT_FILE", trace_path.c_str(), 1);
+    check_seq = true;
+  }
+  // Transaction buffering in its default drop-aborts mode removes aborted
+  // transactions' events from the trace while events_logged still counts
+  // them, so only the gap-free part of the seq check must be skipped; the
+  // range and duplicate checks still apply.
+  const char* trx_buffer_env = std::getenv("ISOFUZZ_TRX_BUFFER");
+  const char* abort_mode_env = std::getenv("ISOFUZZ_TRX_BUFFER_ABORTS");
+  bool expect_complete_seq =
+    !(trx_buffer_env != nullptr && std::strcmp(trx_buffer_env, "1") == 0 &&
+      !(abort_mode_env != nullptr && std::strcmp(abort_mode_env, "emit") == 0));
+
+  isofuzz_init();
+
+  std::vector<WorkerResult> results(static_cast<size_t>(cfg.threads));
+  std::vector<std::thread> workers;
+  workers.reserve(static_cast<size_t>(cfg.threads));
+
+  auto start = Clock::now();
+  for (int i = 0; i < cfg.threads; ++i)
+  {
+    workers.emplace_back(worker_run, std::cref(cfg), i, std::ref(results[static_cast<size_t>(i)]));
+  }
+
+  std::this_thread::sleep_for(std::chrono::seconds(cfg.seconds));
+  g_stop.store(true, std::memory_order_relaxed);
+
+  // Invariant: no lost wakeups. Every worker must come home within the
+  // grace period; one that doesn't is blocked inside the library.
+  auto stop_time = Clock::now();
+  while (g_finished_workers.load(std::memory_order_relaxed) < cfg.threads)
+  {
+    if (std::chrono::duration_cast<std::chrono::seconds>(Clock::now() - stop_time).count()
+      >= JOIN_GRACE_SECONDS)
+    {
+      std::fprintf(stderr,
+                   "INVARIANT lost-wakeup: %d of %d workers still blocked %ds after stop\n",
+                   cfg.threads - g_finished_workers.load(std::memory_order_relaxed),
+                   cfg.threads, JOIN_GRACE_SECONDS);
+      // Deliberately no shutdown/join: exit while the evidence (stuck
+      // threads, scheduler state) is still inspectable in a debugger.
+      return 1;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+  for (auto& w : workers)
+  {
+    w.join();
+  }
+  auto elapsed_s = std::chrono::duration<double>(Clock::now() - start).count();
+
+  bool failed = false;
+
+  // Invariant: no leaked waiters. With every worker returned, each
+  // scheduling request must have been answered by a release or an
+  // explicit cancellation.
+  IsoFuzzStats stats{};
+  isofuzz_get_stats(&stats);
+  if (stats.requests != stats.releases + stats.cancellations)
+  {
+    std::fprintf(stderr,
+                 "INVARIANT leaked-waiter: requests=%llu releases=%llu cancellations=%llu\n",
+                 static_cast<unsigned long long>(stats.requests),
+                 static_cast<unsigned long long>(stats.releases),
+                 static_cast<unsigned long long>(stats.cancellations));
+    failed = true;
+  }
+
+  isofuzz_shutdown();
+
+  if (check_seq &&
+    !check_sequence_numbers(trace_path, stats.events_logged, expect_complete_seq))
+  {
+    failed = true;
+  }
+  if (check_seq && !failed)
+  {
+    std::remove(trace_path.c_str());
+  }
+
+  std::vector<uint64_t> all;
+  uint64_t total_ops = 0;
+  uint64_t total_aborts = 0;
+  for (const auto& r : results)
+  {
+    all.insert(all.end(), r.trx_latencies_ns.begin(), r.trx_latencies_ns.end());
+    total_ops += r.ops;
+    total_aborts += r.aborts;
+  }
+  std::sort(all.begin(), all.end());
+
+  std::printf("threads=%d seconds=%d ops_per_trx=%d tables=%d rows=%llu "
+              "mix=%d:%d:%d:%d abort_pct=%d\n",
+              cfg.threads, cfg.seconds, cfg.ops_per_trx, cfg.tables,
+              static_cast<unsigned long long>(cfg.rows),
+              cfg.mix[0], cfg.mix[1], cfg.mix[2], cfg.mix[3], cfg.abort_pct);
+  std::printf("transactions  %zu (%llu aborted)\n", all.size(),
+              static_cast<unsigned long long>(total_aborts));
+  std::printf("txn/sec       %.0f\n", static_cast<double>(all.size()) / elapsed_s);
+  std::printf("ops/sec       %.0f\n", static_cast<double>(total_ops) / elapsed_s);
+  std::printf("p50 txn       %lu ns\n", static_cast<unsigned long>(percentile(all, 0.50)));
+  std::printf("p99 txn       %lu ns\n", static_cast<unsigned long>(percentile(all, 0.99)));
+  std::printf("max txn       %lu ns\n", all.empty() ? 0ul : static_cast<unsigned long>(all.back()));
+  std::printf("epochs        %llu (avg batch %.1f, max %llu)\n",
+              static_cast<unsigned long long>(stats.epochs),
+              stats.epochs ? static_cast<double>(stats.total_batch) / static_cast<double>(stats.epochs) : 0.0,
+              static_cast<unsigned long long>(stats.max_batch));
+  std::printf("invariants    %s\n", failed ? "FAILED" : "ok");
+  return failed ? 1 : 0;
+}